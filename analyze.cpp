@@ -0,0 +1,1048 @@
+/*
+    analyze.cpp
+
+    Measures of source code from srcML, with an embedded XML parser:
+    * No checking for well-formedness
+    * No DTD declarations
+*/
+
+#include "analyze.hpp"
+#include "parseEvent.hpp"
+#include "analyzerPool.hpp"
+#include "refillBuffer.hpp"
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <ctype.h>
+#include <string_view>
+#include <optional>
+#include <iomanip>
+#include <memory>
+#include <bitset>
+#include <array>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+std::bitset<128> tagNameMask("00000111111111111111111111111110100001111111111111111111111111100000001111111111011000000000000000000000000000000000000000000000");
+
+// dispatch with computed goto (labels as values) where the compiler supports it
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(NO_COMPUTED_GOTO)
+#define COMPUTED_GOTO
+#endif
+
+/*
+    Token classes for dispatch in the main parsing loop.
+    Ordered by hand by the expected frequency in srcML: characters and tags first.
+*/
+enum TokenClass : unsigned char {
+    CHARACTERS, START_TAG, END_TAG, ENTITY, ATTRIBUTE, BANG, QUESTION, IN_XML_COMMENT, IN_CDATA, MARKUP
+};
+
+/*
+    Token class from the first byte of a token.
+    Markup, '<', is further classified by the second byte using markupClass.
+*/
+constexpr auto firstByteClass = [] {
+    std::array<TokenClass, 256> table{};
+    for (auto& tokenClass : table)
+        tokenClass = CHARACTERS;
+    table['<'] = MARKUP;
+    table['&'] = ENTITY;
+    return table;
+}();
+
+/*
+    Token class of markup, '<', from the second byte of the token.
+*/
+constexpr auto markupClass = [] {
+    std::array<TokenClass, 256> table{};
+    for (auto& tokenClass : table)
+        tokenClass = START_TAG;
+    table['/'] = END_TAG;
+    table['!'] = BANG;
+    table['?'] = QUESTION;
+    return table;
+}();
+
+/*
+    Up to the first 8 bytes of a name packed into an integer, with the first
+    byte in the low-order byte, so that short names compare as integers.
+
+    @param[in] name Name of at most 8 bytes
+    @return Name word
+*/
+constexpr uint64_t nameWord(std::string_view name) {
+    uint64_t word = 0;
+    for (size_t i = 0; i < name.size() && i < 8; ++i)
+        word |= static_cast<uint64_t>(static_cast<unsigned char>(name[i])) << (8 * i);
+    return word;
+}
+
+/*
+    Load the 8 bytes at p as a name word.
+
+    @param[in] p Pointer to at least 8 bytes
+    @return Name word, as in nameWord()
+*/
+inline uint64_t loadNameWord(const char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+/*
+    Number of leading bytes of the name word that are in the srcML
+    element name characters [_a-z]. Computed on all 8 bytes at once:
+    the lowest flagged byte of each mask is exact.
+
+    @param[in] word Name word
+    @return Number of leading name characters, 8 if all of them
+*/
+inline int shortNameLength(uint64_t word) {
+    constexpr uint64_t ONES  = 0x0101010101010101ULL;
+    constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+    const uint64_t below = (word - ONES * '_') & ~word & HIGHS;
+    const uint64_t above = ((word + ONES * (127 - 'z')) | word) & HIGHS;
+    const uint64_t backquoteZero = word ^ (ONES * '`');
+    const uint64_t backquote = (backquoteZero - ONES) & ~backquoteZero & HIGHS;
+    const uint64_t boundary = below | above | backquote;
+    if (!boundary)
+        return 8;
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, boundary);
+    return static_cast<int>(index / 8);
+#else
+    return __builtin_ctzll(boundary) / 8;
+#endif
+}
+
+/*
+    Whether the character ends a name, i.e., it is an ASCII character
+    that is neither a name character nor a prefix ':'
+
+    @param[in] c Character after the name
+    @return Whether c is a name boundary
+*/
+inline bool isNameBoundary(char c) {
+    return static_cast<unsigned char>(c) < 128 && c != ':' && !tagNameMask[c];
+}
+
+/*
+    Find the end of a name, i.e., the first character that is not a name character.
+    With SSSE3, 16 bytes at a time are classified by PSHUFB lookups on the low and
+    high nibble of each byte, where a byte is a name character when the two lookups
+    share a bit:
+    * 0x01 '-' '.'
+    * 0x02 '0'-'9'
+    * 0x04 'A'-'O' 'a'-'o'
+    * 0x08 'P'-'Z' 'p'-'z'
+    * 0x20 '_'
+
+    @param[in] first Start of the name
+    @param[in] last End of the data
+    @return Iterator to the first non-name character, or last
+*/
+inline std::string::const_iterator findNameEnd(std::string::const_iterator first, std::string::const_iterator last) {
+#ifdef __SSSE3__
+    if (std::distance(first, last) >= 16) {
+        const __m128i lowNibbleTable  = _mm_setr_epi8(0x0a, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e, 0x0e,
+                                                      0x0e, 0x0e, 0x0c, 0x04, 0x04, 0x05, 0x05, 0x24);
+        const __m128i highNibbleTable = _mm_setr_epi8(0x00, 0x00, 0x01, 0x02, 0x04, 0x28, 0x04, 0x08,
+                                                      0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00);
+        const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+        const char* p = std::addressof(*first);
+        const char* const blockEnd = p + (std::distance(first, last) & ~15);
+        for (; p != blockEnd; p += 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i lowNibbles = _mm_and_si128(block, nibbleMask);
+            const __m128i highNibbles = _mm_and_si128(_mm_srli_epi16(block, 4), nibbleMask);
+            const __m128i classes = _mm_and_si128(_mm_shuffle_epi8(lowNibbleTable, lowNibbles),
+                                                  _mm_shuffle_epi8(highNibbleTable, highNibbles));
+            const int nonName = _mm_movemask_epi8(_mm_cmpeq_epi8(classes, _mm_setzero_si128()));
+            if (nonName)
+                return std::next(first, (p - std::addressof(*first)) + __builtin_ctz(static_cast<unsigned>(nonName)));
+        }
+        first = std::next(first, blockEnd - std::addressof(*first));
+    }
+#endif
+    return std::find_if_not(first, last, [] (char c) { return static_cast<unsigned char>(c) < 128 && tagNameMask[c]; });
+}
+
+/*
+    Find the end of a run of characters, i.e., the next '<' or '&', and count
+    the newlines in the run in the same pass. With SSE2, each 64-byte block
+    produces a 64-bit mask of markup starts and a 64-bit mask of newlines, and
+    the newlines before the first markup start are counted with a popcount.
+
+    @param[in] first Start of the characters
+    @param[in] last End of the data
+    @param[in,out] newlines Incremented by the number of newlines in the run
+    @return Iterator to the first '<' or '&', or last
+*/
+inline std::string::const_iterator findCharactersEnd(std::string::const_iterator first, std::string::const_iterator last, int& newlines) {
+#ifdef __SSE2__
+    const char* p = std::addressof(*first);
+    const char* const start = p;
+    const char* const end = start + std::distance(first, last);
+    const __m128i lessThan = _mm_set1_epi8('<');
+    const __m128i ampersand = _mm_set1_epi8('&');
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 64; p += 64) {
+        uint64_t markupMask = 0;
+        uint64_t newlineMask = 0;
+        for (int i = 0; i < 4; ++i) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+            const __m128i markup = _mm_or_si128(_mm_cmpeq_epi8(block, lessThan), _mm_cmpeq_epi8(block, ampersand));
+            markupMask  |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(markup))) << (16 * i);
+            newlineMask |= static_cast<uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)))) << (16 * i);
+        }
+        if (markupMask) {
+            const int offset = __builtin_ctzll(markupMask);
+            newlines += __builtin_popcountll(newlineMask & ((uint64_t(1) << offset) - 1));
+            return std::next(first, (p - start) + offset);
+        }
+        newlines += __builtin_popcountll(newlineMask);
+    }
+    first = std::next(first, p - start);
+#endif
+    for (; first != last; ++first) {
+        if (*first == '<' || *first == '&')
+            break;
+        if (*first == '\n')
+            ++newlines;
+    }
+    return first;
+}
+
+/*
+    Count the newlines in the characters. With SSE2, 16 bytes at a time.
+
+    @param[in] characters Characters to count
+    @return Number of newlines
+*/
+inline int countNewlines(std::string_view characters) {
+    int newlines = 0;
+    const char* p = characters.data();
+    const char* const end = p + characters.size();
+#ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        newlines += __builtin_popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline))));
+    }
+#endif
+    return newlines + static_cast<int>(std::count(p, end, '\n'));
+}
+
+/*
+    Find the terminator of an XML comment, "-->", or CDATA section, "]]>", in
+    streaming data. A terminator split across buffer refills is completed from
+    the partial match carried over from the previous data, so no data is
+    scanned twice. The bytes of a partial match are held back from the content
+    until the match completes or fails.
+
+    @param[in,out] cursor Iterator to current position in buffer, advanced past the terminator or to cursorEnd
+    @param[in] cursorEnd Iterator to end of buffer for this read
+    @param[in] terminator Terminator of 3 bytes, where the first two are the same
+    @param[in,out] matched Length of the partial match at the end of the previous data on entry, and
+        at the end of this data on exit. Reset to 0 when the terminator is found.
+    @param[out] content Content before the terminator in this data
+    @param[out] released Number of held back bytes that turned out to be content
+    @return Whether the terminator was found
+*/
+inline bool findTerminator(std::string::const_iterator& cursor, std::string::const_iterator cursorEnd,
+    std::string_view terminator, int& matched, std::string_view& content, int& released) {
+
+    // continue a partial match from the previous data
+    released = 0;
+    content = std::string_view();
+    while (matched > 0 && cursor != cursorEnd) {
+        if (matched == 2 && *cursor == terminator[2]) {
+            std::advance(cursor, 1);
+            matched = 0;
+            return true;
+        }
+        if (*cursor != terminator[1]) {
+            released += matched;
+            matched = 0;
+            break;
+        }
+        // another repeated first byte, e.g., "]]]", releases the oldest one
+        if (matched == 2)
+            ++released;
+        matched = 2;
+        std::advance(cursor, 1);
+    }
+    if (cursor == cursorEnd)
+        return false;
+
+    // search the rest of the data
+    const std::string_view data(std::addressof(*cursor), std::distance(cursor, cursorEnd));
+    const size_t position = data.find(terminator);
+    if (position != std::string_view::npos) {
+        content = data.substr(0, position);
+        std::advance(cursor, position + terminator.size());
+        return true;
+    }
+
+    // hold back a partial match at the end of the data
+    if (data.size() >= 2 && data[data.size() - 2] == terminator[0] && data.back() == terminator[1])
+        matched = 2;
+    else if (data.back() == terminator[0])
+        matched = 1;
+    content = data.substr(0, data.size() - matched);
+    cursor = cursorEnd;
+    return false;
+}
+
+// trace parsing
+#ifdef TRACE
+#undef TRACE
+#define HEADER(m) std::clog << std::setw(10) << std::left << m <<"\t"
+#define FIELD(l, n) l << ":|" << n << "| "
+#define TRACE0(m)
+#define TRACE1(m, l1, n1) HEADER(m) << FIELD(l1,n1) << '\n';
+#define TRACE2(m, l1, n1, l2, n2) HEADER(m) << FIELD(l1,n1) << FIELD(l2,n2) << '\n';
+#define TRACE3(m, l1, n1, l2, n2, l3, n3) HEADER(m) << FIELD(l1,n1) << FIELD(l2,n2) << FIELD(l3,n3) << '\n';
+#define TRACE4(m, l1, n1, l2, n2, l3, n3, l4, n4) HEADER(m) << FIELD(l1,n1) << FIELD(l2,n2) << FIELD(l3,n3) << FIELD(l4,n4) << '\n';
+#define GET_TRACE(_1,_2,_3,_4,_5,_6,_7,_8,_9,NAME,...) NAME
+#define TRACE(...) GET_TRACE(__VA_ARGS__, TRACE4, _UNUSED, TRACE3, _UNUSED, TRACE2, _UNUSED, TRACE1, _UNUSED, TRACE0)(__VA_ARGS__)
+#else
+#define TRACE(...)
+#endif
+
+// record parse events when requested
+#define EVENT(...) do { if (events) events->push_back(ParseEvent{ __VA_ARGS__ }); } while (false)
+/*
+    Analyzer with an empty buffer, ready for input
+*/
+Analyzer::Analyzer()
+    : buffer(BUFFER_SIZE + BUFFER_PADDING, '\0') {
+    reset();
+}
+
+/*
+    Reset for a new document, keeping the buffer
+*/
+void Analyzer::reset() {
+    counts = Facts();
+    depth = 0;
+    inTag = false;
+    inXMLComment = false;
+    inCDATA = false;
+    terminatorMatched = 0;
+    inTagQName = std::string_view();
+    inTagPrefix = std::string_view();
+    inTagLocalName = std::string_view();
+    cursor = buffer.cbegin();
+    cursorEnd = buffer.cbegin();
+    lastParsed = std::string_view();
+    std::fill(buffer.begin(), std::next(buffer.begin(), BUFFER_PADDING), '\0');
+    TRACE("START DOCUMENT");
+}
+
+/*
+    Read the next part of the document from the input and parse it.
+    Data from an incomplete token is kept for the next read.
+
+    @param[in] input Source of srcML
+    @return Number of bytes read
+    @retval 0 EOF
+*/
+int Analyzer::read(InputSource& input) {
+    const int bytesRead = refill(input);
+    if (bytesRead > 0) {
+        parseBuffer();
+    } else {
+        if (events)
+            events->clear();
+        lastParsed = std::string_view();
+    }
+    return bytesRead;
+}
+
+/*
+    Parse the complete tokens of the buffer, replacing the recorded events
+    and parsed data with theirs
+*/
+void Analyzer::parseBuffer() {
+    if (events)
+        events->clear();
+    const std::string::const_iterator parseStart = cursor;
+    cursor = parse(cursor, cursorEnd, false);
+    lastParsed = std::string_view(std::addressof(*parseStart), std::distance(parseStart, cursor));
+}
+
+/*
+    Read the next part of the document from the input into the buffer,
+    without parsing it. Data from an incomplete token is kept.
+
+    @param[in] input Source of srcML
+    @return Number of bytes read
+    @retval 0 EOF
+*/
+int Analyzer::refill(InputSource& input) {
+    if (std::distance(cursor, cursorEnd) == BUFFER_SIZE)
+        throw ParseError("parser error : Token larger than the buffer");
+    if (inTag)
+        saveInTagName();
+    const int bytesRead = refillBuffer(input, cursor, cursorEnd, buffer);
+    if (bytesRead < 0)
+        throw ParseError("parser error : File input error");
+    counts.totalBytes += bytesRead;
+    return bytesRead;
+}
+
+/*
+    Parse the next complete tokens of the buffer, appending their events
+    when recording
+
+    @param[in] maxTokens Maximum number of tokens to parse
+    @param[in] isFinal Whether the buffer has the end of the document
+    @return Whether any token was parsed, false when the buffer needs a refill, or at the end
+*/
+bool Analyzer::parseTokens(int maxTokens, bool isFinal) {
+    const std::string::const_iterator parseStart = cursor;
+    tokenLimit = maxTokens;
+    try {
+        cursor = parse(cursor, cursorEnd, isFinal);
+    } catch (...) {
+        tokenLimit = INT_MAX;
+        throw;
+    }
+    tokenLimit = INT_MAX;
+    lastParsed = std::string_view(std::addressof(*parseStart), std::distance(parseStart, cursor));
+    return cursor != parseStart;
+}
+
+/*
+    Copy the name of the current start tag out of the buffer, since
+    the next refill overwrites it
+*/
+void Analyzer::saveInTagName() {
+    // saved by an earlier refill in the same start tag
+    if (inTagQName.data() == inTagName.data())
+        return;
+    // assigned, not swapped, so the capacity is kept for reuse
+    inTagName.assign(inTagQName);
+    const size_t localNameOffset = inTagName.size() - inTagLocalName.size();
+    inTagQName = inTagName;
+    inTagPrefix = std::string_view(inTagName.data(), inTagPrefix.size());
+    inTagLocalName = std::string_view(inTagName.data() + localNameOffset, inTagLocalName.size());
+}
+
+/*
+    Parse the next chunk of the document. Tokens may be split anywhere
+    across chunks.
+
+    @param[in] chunk Next part of the srcML document
+*/
+void Analyzer::feed(std::string_view chunk) {
+    // refill only while there is data, since a refill moves the data the events and parsed() view
+    if (events)
+        events->clear();
+    lastParsed = std::string_view();
+    while (!chunk.empty()) {
+        StringSource input(chunk);
+        chunk.remove_prefix(refill(input));
+        parseBuffer();
+    }
+}
+
+/*
+    Parse the rest of the document after the last input
+
+    @return Measures of the document
+*/
+const Facts& Analyzer::finish() {
+    if (events)
+        events->clear();
+    const std::string::const_iterator parseStart = cursor;
+    cursor = parse(cursor, cursorEnd, true);
+    lastParsed = std::string_view(std::addressof(*parseStart), std::distance(parseStart, cursor));
+    TRACE("END DOCUMENT");
+    return counts;
+}
+
+/*
+    Parse the complete tokens in the data. Unless this is the final data, an
+    incomplete token at the end is left for the next call.
+
+    @param[in] cursor Iterator to current position in buffer
+    @param[in] cursorEnd Iterator to end of buffer for this read
+    @param[in] isFinal Whether this is the end of the document
+    @return Iterator to the first unparsed character
+*/
+std::string::const_iterator Analyzer::parse(std::string::const_iterator cursor, std::string::const_iterator cursorEnd, bool isFinal) {
+    // parse with the hot state in locals, saved back on any return or exception
+    int depth = this->depth;
+    Facts counts = std::move(this->counts);
+    struct SaveState {
+        Analyzer& analyzer;
+        int& depth;
+        Facts& counts;
+        ~SaveState() {
+            analyzer.depth = depth;
+            analyzer.counts = std::move(counts);
+        }
+    } saveState{ *this, depth, counts };
+    int tokensLeft = tokenLimit;
+    while (true) {
+        // stop after the limit of tokens, when parsing in steps
+        if (tokensLeft-- == 0)
+            return cursor;
+        // need at least 5 characters for token lookahead, except for comments and CDATA, which take any
+        if (std::distance(cursor, cursorEnd) < 5 && (cursor == cursorEnd || !(inXMLComment | inCDATA))) {
+            if (!isFinal)
+                return cursor;
+            if (cursor == cursorEnd) {
+                if (inXMLComment)
+                    throw ParseError("parser error : Unterminated XML comment");
+                if (inCDATA)
+                    throw ParseError("parser error : Unterminated CDATA");
+                return cursor;
+            }
+        }
+        {
+            // classify the token, with the uncommon in-progress states checked together
+            TokenClass tokenClass;
+            if (inTag | inXMLComment | inCDATA) {
+                tokenClass = inTag ? ATTRIBUTE : (inXMLComment ? IN_XML_COMMENT : IN_CDATA);
+            } else {
+                tokenClass = firstByteClass[static_cast<unsigned char>(*cursor)];
+                if (tokenClass == MARKUP)
+                    tokenClass = markupClass[static_cast<unsigned char>(cursor[1])];
+            }
+#ifdef COMPUTED_GOTO
+            static const void* const tokenTargets[] = {
+                &&characters, &&startTag, &&endTag, &&entity, &&attribute, &&bang, &&question, &&xmlComment, &&cdata
+            };
+            goto *tokenTargets[tokenClass];
+#else
+            switch (tokenClass) {
+            case CHARACTERS:     goto characters;
+            case START_TAG:      goto startTag;
+            case END_TAG:        goto endTag;
+            case ENTITY:         goto entity;
+            case ATTRIBUTE:      goto attribute;
+            case BANG:           goto bang;
+            case QUESTION:       goto question;
+            case IN_XML_COMMENT: goto xmlComment;
+            case IN_CDATA:       goto cdata;
+            case MARKUP:         break;
+            }
+#endif
+        }
+    characters:
+        if (depth == 0) {
+            // parse characters before or after XML
+            const std::string::const_iterator contentEnd = std::find_if_not(cursor, cursorEnd, isspace);
+            if (contentEnd == cursor)
+                throw ParseError("parser error : Characters outside of the root element");
+            cursor = contentEnd;
+        } else {
+            // parse character non-entity references
+            const std::string::const_iterator tagEnd = findCharactersEnd(cursor, cursorEnd, counts.loc);
+            const std::string_view characters(std::addressof(*cursor), std::distance(cursor, tagEnd));
+            TRACE("CHARACTERS", "characters", characters);
+            EVENT(ParseEvent::CHARACTERS, {}, {}, characters);
+            counts.textsize += static_cast<int>(characters.size());
+            std::advance(cursor, characters.size());
+        }
+        continue;
+    bang:
+        // hand-chosen order, by expected frequency: XML comments, then CDATA
+        if (std::distance(cursor, cursorEnd) < 9 && !isFinal)
+            return cursor;
+        if (cursor[2] == '-' && cursor[3] == '-')
+            goto xmlComment;
+        if (cursor[2] == '[' && (strncmp(std::addressof(cursor[3]), "CDATA[", 6) == 0))
+            goto cdata;
+        goto startTag;
+    question:
+        // hand-chosen order, by expected frequency: processing instructions, then the single XML declaration
+        if (std::distance(cursor, cursorEnd) < 6 && !isFinal)
+            return cursor;
+        if (strncmp(std::addressof(*cursor), "<?xml ", 6) != 0)
+            goto processingInstruction;
+        goto xmlDeclaration;
+    attribute:
+        {
+            // whitespace and end of the start tag, when split from the previous attribute by the end of the data
+            if (isspace(*cursor))
+                cursor = std::find_if_not(cursor, cursorEnd, isspace);
+            if (std::distance(cursor, cursorEnd) < 2) {
+                if (!isFinal)
+                    return cursor;
+                if (cursor == cursorEnd)
+                    throw ParseError("parser error: Incomplete element start tag");
+            }
+            if (*cursor == '>') {
+                std::advance(cursor, 1);
+                inTag = false;
+                ++depth;
+                continue;
+            }
+            if (*cursor == '/' && cursor[1] == '>') {
+                std::advance(cursor, 2);
+                TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
+                EVENT(ParseEvent::END_TAG, inTagPrefix, inTagLocalName);
+                inTag = false;
+                continue;
+            }
+        }
+        if ((strncmp(std::addressof(*cursor), "xmlns", 5) == 0) && (cursor[5] == ':' || cursor[5] == '=')) {
+            // parse XML namespace
+            const std::string::const_iterator attributeStart = cursor;
+            std::advance(cursor, 5);
+            const std::string::const_iterator nameEnd = std::find(cursor, cursorEnd, '=');
+            if (nameEnd == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : incomplete namespace");
+            }
+            int prefixSize = 0;
+            if (*cursor == ':') {
+                std::advance(cursor, 1);
+                prefixSize = std::distance(cursor, nameEnd);
+            }
+            const std::string_view prefix(std::addressof(*cursor), prefixSize);
+            cursor = std::next(nameEnd);
+            cursor = std::find_if_not(cursor, cursorEnd, isspace);
+            if (cursor == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : incomplete namespace");
+            }
+            const char delimiter = *cursor;
+            if (delimiter != '"' && delimiter != '\'')
+                throw ParseError("parser error : incomplete namespace");
+            std::advance(cursor, 1);
+            const std::string::const_iterator valueEnd = std::find(cursor, cursorEnd, delimiter);
+            if (valueEnd == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : incomplete namespace");
+            }
+            const std::string_view uri(std::addressof(*cursor), std::distance(cursor, valueEnd));
+            TRACE("NAMESPACE", "prefix", prefix, "uri", uri);
+            EVENT(ParseEvent::NAMESPACE, prefix, {}, uri);
+            cursor = std::next(valueEnd);
+            cursor = std::find_if_not(cursor, cursorEnd, isspace);
+            if (*cursor == '>') {
+                std::advance(cursor, 1);
+                inTag = false;
+                ++depth;
+            } else if (*cursor == '/' && cursor[1] == '>') {
+                std::advance(cursor, 2);
+                TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
+                EVENT(ParseEvent::END_TAG, inTagPrefix, inTagLocalName);
+                inTag = false;
+            }
+        } else {
+            // parse attribute
+            const std::string::const_iterator attributeStart = cursor;
+            const std::string::const_iterator nameEnd = findNameEnd(cursor, cursorEnd);
+            if (nameEnd == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : Empty attribute name");
+            }
+            const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
+            size_t colonPosition = qName.find(':');
+            if (colonPosition == 0)
+                throw ParseError("parser error : Invalid attribute name " + std::string(qName));
+            if (colonPosition == std::string::npos)
+                colonPosition = 0;
+            const std::string_view prefix(std::addressof(*qName.cbegin()), colonPosition);
+            if (colonPosition != 0)
+                colonPosition += 1;
+            const std::string_view localName(std::addressof(*qName.cbegin()) + colonPosition, qName.size() - colonPosition);
+            cursor = nameEnd;
+            if (isspace(*cursor))
+                cursor = std::find_if_not(cursor, cursorEnd, isspace);
+            if (cursor == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : attribute " + std::string(qName) + " incomplete attribute");
+            }
+            if (*cursor != '=')
+                throw ParseError("parser error : attribute " + std::string(qName) + " missing =");
+            std::advance(cursor, 1);
+            if (isspace(*cursor))
+                cursor = std::find_if_not(cursor, cursorEnd, isspace);
+            if (cursor == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : attribute " + std::string(qName) + " missing delimiter");
+            }
+            const char delimiter = *cursor;
+            if (delimiter != '"' && delimiter != '\'')
+                throw ParseError("parser error : attribute " + std::string(qName) + " missing delimiter");
+            std::advance(cursor, 1);
+            std::string::const_iterator valueEnd = std::find(cursor, cursorEnd, delimiter);
+            if (valueEnd == cursorEnd) {
+                if (!isFinal)
+                    return attributeStart;
+                throw ParseError("parser error : attribute " + std::string(qName) + " missing delimiter");
+            }
+            const std::string_view value(std::addressof(*cursor), std::distance(cursor, valueEnd));
+            if (localName == "url"sv)
+                counts.url = value;
+            TRACE("ATTRIBUTE", "prefix", prefix, "qname", qName, "localName", localName, "value", value);
+            EVENT(ParseEvent::ATTRIBUTE, prefix, localName, value);
+            cursor = std::next(valueEnd);
+            if (isspace(*cursor))
+                cursor = std::find_if_not(std::next(cursor), cursorEnd, isspace);
+            if (*cursor == '>') {
+                std::advance(cursor, 1);
+                inTag = false;
+                ++depth;
+            } else if (*cursor == '/' && cursor[1] == '>') {
+                std::advance(cursor, 2);
+                TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
+                EVENT(ParseEvent::END_TAG, inTagPrefix, inTagLocalName);
+                inTag = false;
+            }
+        }
+        continue;
+    xmlComment:
+        {
+            // parse XML comment
+            if (!inXMLComment)
+                std::advance(cursor, 4);
+            constexpr std::string_view endComment = "-->"sv;
+            std::string_view comment;
+            int released = 0;
+            inXMLComment = !findTerminator(cursor, cursorEnd, endComment, terminatorMatched, comment, released);
+            TRACE("COMMENT", "comment", comment);
+            if (released)
+                EVENT(ParseEvent::COMMENT, {}, {}, endComment.substr(0, released));
+            if (!comment.empty())
+                EVENT(ParseEvent::COMMENT, {}, {}, comment);
+        }
+        continue;
+    cdata:
+        {
+            // parse CDATA
+            constexpr std::string_view endCDATA = "]]>"sv;
+            if (!inCDATA)
+                std::advance(cursor, 9);
+            std::string_view characters;
+            int released = 0;
+            inCDATA = !findTerminator(cursor, cursorEnd, endCDATA, terminatorMatched, characters, released);
+            TRACE("CDATA", "characters", characters);
+            if (released)
+                EVENT(ParseEvent::CDATA, {}, {}, endCDATA.substr(0, released));
+            if (!characters.empty())
+                EVENT(ParseEvent::CDATA, {}, {}, characters);
+            counts.textsize += static_cast<int>(characters.size()) + released;
+            counts.loc += countNewlines(characters);
+        }
+        continue;
+    xmlDeclaration:
+        {
+            // parse XML declaration
+            constexpr std::string_view startXMLDecl = "<?xml";
+            constexpr std::string_view endXMLDecl = "?>";
+            std::string::const_iterator tagEnd = std::find(cursor, cursorEnd, '>');
+            if (tagEnd == cursorEnd) {
+                if (!isFinal)
+                    return cursor;
+                throw ParseError("parser error: Incomplete XML declaration");
+            }
+            std::advance(cursor, startXMLDecl.size());
+            cursor = std::find_if_not(cursor, tagEnd, isspace);
+            // parse required version
+            if (cursor == tagEnd)
+                throw ParseError("parser error: Missing space after before version in XML declaration");
+            std::string::const_iterator nameEnd = std::find(cursor, tagEnd, '=');
+            const std::string_view attr(std::addressof(*cursor), std::distance(cursor, nameEnd));
+            cursor = std::next(nameEnd);
+            const char delimiter = *cursor;
+            if (delimiter != '"' && delimiter != '\'')
+                throw ParseError("parser error: Invalid start delimiter for version in XML declaration");
+            std::advance(cursor, 1);
+            std::string::const_iterator valueEnd = std::find(cursor, tagEnd, delimiter);
+            if (valueEnd == tagEnd)
+                throw ParseError("parser error: Invalid end delimiter for version in XML declaration");
+            if (attr != "version"sv)
+                throw ParseError("parser error: Missing required first attribute version in XML declaration");
+            const std::string_view version(std::addressof(*cursor), std::distance(cursor, valueEnd));
+            cursor = std::next(valueEnd);
+            cursor = std::find_if_not(cursor, tagEnd, isspace);
+            // parse optional encoding and standalone attributes
+            std::optional<std::string_view> encoding;
+            std::optional<std::string_view> standalone;
+            if (cursor != (tagEnd - 1)) {
+                nameEnd = std::find(cursor, tagEnd, '=');
+                if (nameEnd == tagEnd)
+                    throw ParseError("parser error: Incomplete attribute in XML declaration");
+                const std::string_view attr2(std::addressof(*cursor), std::distance(cursor, nameEnd));
+                cursor = std::next(nameEnd);
+                char delimiter2 = *cursor;
+                if (delimiter2 != '"' && delimiter2 != '\'')
+                    throw ParseError("parser error: Invalid end delimiter for attribute " + std::string(attr2) + " in XML declaration");
+                std::advance(cursor, 1);
+                valueEnd = std::find(cursor, tagEnd, delimiter2);
+                if (valueEnd == tagEnd)
+                    throw ParseError("parser error: Incomplete attribute " + std::string(attr2) + " in XML declaration");
+                if (attr2 == "encoding"sv) {
+                    encoding = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
+                } else if (attr2 == "standalone"sv) {
+                    standalone = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
+                } else 
+                    throw ParseError("parser error: Invalid attribute " + std::string(attr2) + " in XML declaration");
+                cursor = std::next(valueEnd);
+                cursor = std::find_if_not(cursor, tagEnd, isspace);
+            }
+            if (cursor != (tagEnd - endXMLDecl.size() + 1)) {
+                nameEnd = std::find(cursor, tagEnd, '=');
+                if (nameEnd == tagEnd)
+                    throw ParseError("parser error: Incomplete attribute in XML declaration");
+                const std::string_view attr2(std::addressof(*cursor), std::distance(cursor, nameEnd));
+                cursor = std::next(nameEnd);
+                const char delimiter2 = *cursor;
+                if (delimiter2 != '"' && delimiter2 != '\'')
+                    throw ParseError("parser error: Invalid end delimiter for attribute " + std::string(attr2) + " in XML declaration");
+                std::advance(cursor, 1);
+                valueEnd = std::find(cursor, tagEnd, delimiter2);
+                if (valueEnd == tagEnd)
+                    throw ParseError("parser error: Incomplete attribute " + std::string(attr2) + " in XML declaration");
+                if (!standalone && attr2 == "standalone"sv) {
+                    standalone = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
+                } else 
+                    throw ParseError("parser error: Invalid attribute " + std::string(attr2) + " in XML declaration");
+                cursor = std::next(valueEnd);
+                cursor = std::find_if_not(cursor, tagEnd, isspace);
+            }
+            TRACE("XML DECLARATION", "version", version, "encoding", (encoding ? *encoding : ""), "standalone", (standalone ? *standalone : ""));
+            EVENT(ParseEvent::XML_DECLARATION, {}, {}, version);
+            std::advance(cursor, endXMLDecl.size());
+            cursor = std::find_if_not(cursor, cursorEnd, isspace);
+        }
+        continue;
+    processingInstruction:
+        {
+            // parse processing instruction
+            constexpr std::string_view endPI = "?>";
+            std::string::const_iterator tagEnd = std::search(cursor, cursorEnd, endPI.begin(), endPI.end());
+            if (tagEnd == cursorEnd) {
+                if (!isFinal)
+                    return cursor;
+                throw ParseError("parser error: Incomplete processing instruction");
+            }
+            std::advance(cursor, 2);
+            std::string::const_iterator nameEnd = findNameEnd(cursor, tagEnd);
+            if (nameEnd == tagEnd)
+                throw ParseError("parser error : Unterminated processing instruction '" + std::string(cursor, nameEnd) + "'");
+            const std::string_view target(std::addressof(*cursor), std::distance(cursor, nameEnd));
+            cursor = std::find_if_not(nameEnd, tagEnd, isspace);
+            const std::string_view data(std::addressof(*cursor), std::distance(cursor, tagEnd));
+            TRACE("PI", "target", target, "data", data);
+            EVENT(ParseEvent::PROCESSING_INSTRUCTION, {}, target, data);
+            cursor = tagEnd;
+            std::advance(cursor, 2);
+        }
+        continue;
+    endTag:
+        {
+            // parse end tag
+            if (std::distance(cursor, cursorEnd) < 100) {
+                std::string::const_iterator tagEnd = std::find(cursor, cursorEnd, '>');
+                if (tagEnd == cursorEnd) {
+                    if (!isFinal)
+                        return cursor;
+                    throw ParseError("parser error: Incomplete element end tag");
+                }
+            }
+            std::advance(cursor, 2);
+            if (*cursor == ':')
+                throw ParseError("parser error : Invalid end tag name");
+            std::string::const_iterator nameEnd = findNameEnd(cursor, cursorEnd);
+            if (nameEnd == cursorEnd)
+                throw ParseError("parser error : Unterminated end tag '" + std::string(cursor, nameEnd) + "'");
+            size_t colonPosition = 0;
+            if (*nameEnd == ':') {
+                colonPosition = std::distance(cursor, nameEnd);
+                nameEnd = findNameEnd(std::next(nameEnd), cursorEnd);
+            }
+            const std::string_view prefix(std::addressof(*cursor), colonPosition);
+            const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
+            if (qName.empty())
+                throw ParseError("parser error: EndTag: invalid element name");
+            if (colonPosition)
+                ++colonPosition;
+            const std::string_view localName(std::addressof(*cursor) + colonPosition, std::distance(cursor, nameEnd) - colonPosition);
+            cursor = std::next(nameEnd);
+            --depth;
+            TRACE("END TAG", "prefix", prefix, "qName", qName, "localName", localName);
+            EVENT(ParseEvent::END_TAG, prefix, localName);
+        }
+        continue;
+    startTag:
+        {
+            // parse start tag
+            if (std::distance(cursor, cursorEnd) < 200) {
+                std::string::const_iterator tagEnd = std::find(cursor, cursorEnd, '>');
+                if (tagEnd == cursorEnd) {
+                    if (!isFinal)
+                        return cursor;
+                    throw ParseError("parser error: Incomplete element start tag");
+                }
+            }
+            std::advance(cursor, 1);
+            if (*cursor == ':')
+                throw ParseError("parser error : Invalid start tag name");
+            // fast path for short srcML names, [prefix:]local with parts of at most 8 bytes,
+            // with the local name loaded as a word
+            std::string::const_iterator nameEnd;
+            size_t colonPosition = 0;
+            uint64_t localWord = 0;
+            bool isShortName = false;
+            if (std::distance(cursor, cursorEnd) > 8) {
+                uint64_t word = loadNameWord(std::addressof(*cursor));
+                int length = shortNameLength(word);
+                nameEnd = std::next(cursor, length);
+                if (*nameEnd == ':' && length > 0 && std::distance(nameEnd, cursorEnd) > 9) {
+                    colonPosition = length;
+                    word = loadNameWord(std::addressof(nameEnd[1]));
+                    length = shortNameLength(word);
+                    nameEnd = std::next(nameEnd, 1 + length);
+                }
+                if (length > 0 && isNameBoundary(*nameEnd)) {
+                    localWord = length == 8 ? word : word & ((uint64_t(1) << (8 * length)) - 1);
+                    isShortName = true;
+                }
+            }
+            if (!isShortName) {
+                nameEnd = findNameEnd(cursor, cursorEnd);
+                if (nameEnd == cursorEnd)
+                    throw ParseError("parser error : Unterminated start tag '" + std::string(cursor, nameEnd) + "'");
+                colonPosition = 0;
+                if (*nameEnd == ':') {
+                    colonPosition = std::distance(cursor, nameEnd);
+                    nameEnd = findNameEnd(std::next(nameEnd), cursorEnd);
+                }
+            }
+            const std::string_view prefix(std::addressof(*cursor), colonPosition);
+            const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
+            if (qName.empty())
+                throw ParseError("parser error: StartTag: invalid element name");
+            if (colonPosition)
+                ++colonPosition;
+            const std::string_view localName(std::addressof(*cursor) + colonPosition, std::distance(cursor, nameEnd) - colonPosition);
+            TRACE("START TAG", "prefix", prefix, "qName", qName, "localName", localName);
+            EVENT(ParseEvent::START_TAG, prefix, localName);
+            if (!isShortName && localName.size() <= 8)
+                localWord = nameWord(localName);
+            switch (localWord) {
+            case nameWord("expr"sv):
+                ++counts.exprCount;
+                break;
+            case nameWord("decl"sv):
+                ++counts.declCount;
+                break;
+            case nameWord("comment"sv):
+                ++counts.commentCount;
+                break;
+            case nameWord("function"sv):
+                ++counts.functionCount;
+                break;
+            case nameWord("unit"sv):
+                ++counts.unitCount;
+                if (depth == 1)
+                    counts.isArchive = true;
+                break;
+            case nameWord("class"sv):
+                ++counts.classCount;
+                break;
+            }
+            cursor = nameEnd;
+            if (*cursor != '>')
+                cursor = std::find_if_not(cursor, cursorEnd, isspace);
+            if (*cursor == '>') {
+                std::advance(cursor, 1);
+                ++depth;
+            } else if (*cursor == '/' && cursor[1] == '>') {
+                std::advance(cursor, 2);
+                TRACE("END TAG", "prefix", prefix, "qName", qName, "localName", localName);
+                EVENT(ParseEvent::END_TAG, prefix, localName);
+            } else {
+                inTagQName = qName;
+                inTagPrefix = prefix;
+                inTagLocalName = localName;
+                inTag = true;
+            }
+        }
+        continue;
+    entity:
+        if (depth == 0) {
+            // characters before or after XML
+            goto characters;
+        } else {
+            // parse character entity references
+            std::string_view characters;
+            if (cursor[1] == 'l' && cursor[2] == 't' && cursor[3] == ';') {
+                characters = "<";
+                std::advance(cursor, 4);
+            } else if (cursor[1] == 'g' && cursor[2] == 't' && cursor[3] == ';') {
+                characters = ">";
+                std::advance(cursor, 4);
+            } else if (cursor[1] == 'a' && cursor[2] == 'm' && cursor[3] == 'p' && cursor[4] == ';') {
+                characters = "&";
+                std::advance(cursor, 5);
+            } else {
+                characters = "&";
+                std::advance(cursor, 1);
+            }
+            TRACE("ENTITYREF", "characters", characters);
+            EVENT(ParseEvent::CHARACTERS, {}, {}, characters);
+            ++counts.textsize;
+        }
+    }
+}
+
+/*
+    Analyze srcML from an input source
+
+    @param[in] input Source of srcML
+    @return Measures of the srcML
+*/
+Facts analyze(InputSource& input) {
+    const AnalyzerPool::Lease analyzer = analyzerPool().acquire();
+    while (analyzer->read(input) > 0) {
+    }
+    return analyzer->finish();
+}
+
+/*
+    Analyze srcML in memory
+
+    @param[in] srcML Complete srcML document
+    @return Measures of the srcML
+*/
+Facts analyze(std::string_view srcML) {
+    const AnalyzerPool::Lease analyzer = analyzerPool().acquire();
+    analyzer->feed(srcML);
+    return analyzer->finish();
+}
@@ -0,0 +1,197 @@
+/*
+    analyze.hpp
+
+    Measures of source code from srcML.
+
+    Library interface of srcFacts:
+    * analyze() for a complete input source or srcML in memory
+    * Analyzer for srcML pushed in chunks, e.g., from an in-process producer
+*/
+
+#ifndef INCLUDED_ANALYZE_HPP
+#define INCLUDED_ANALYZE_HPP
+
+#include "inputSource.hpp"
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <cstddef>
+#include <climits>
+#include <vector>
+
+struct ParseEvent;
+
+const int BUFFER_SIZE = 16 * 16 * 4096;
+
+/*
+    Measures of source code from srcML
+*/
+struct Facts {
+    std::string url;
+    long totalBytes = 0;
+    int textsize = 0;
+    int loc = 0;
+    int exprCount = 0;
+    int functionCount = 0;
+    int classCount = 0;
+    int unitCount = 0;
+    int declCount = 0;
+    int commentCount = 0;
+    bool isArchive = false;
+
+    // number of source files, i.e., units not including the archive root unit
+    int files() const {
+        return isArchive ? unitCount - 1 : unitCount;
+    }
+};
+
+/*
+    Error in the srcML input, with the parser error message
+*/
+class ParseError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/*
+    Streaming analyzer of a srcML document. Keeps the parser state and
+    unparsed input between calls, so input can be read or fed in parts.
+    Throws ParseError on invalid srcML or input errors.
+*/
+class Analyzer {
+public:
+    Analyzer();
+    Analyzer(const Analyzer&) = delete;
+    Analyzer& operator=(const Analyzer&) = delete;
+
+    /*
+        Read the next part of the document from the input and parse it
+
+        @param[in] input Source of srcML
+        @return Number of bytes read
+        @retval 0 EOF
+    */
+    int read(InputSource& input);
+
+    /*
+        Read the next part of the document from the input into the buffer,
+        without parsing it, e.g., for parsing a token at a time
+
+        @param[in] input Source of srcML
+        @return Number of bytes read
+        @retval 0 EOF
+    */
+    int refill(InputSource& input);
+
+    /*
+        Parse the next complete tokens of the buffer, appending their events
+        when recording, e.g., for a generator that yields the events in small
+        steps as they are parsed
+
+        @param[in] maxTokens Maximum number of tokens to parse
+        @param[in] isFinal Whether the buffer has the end of the document
+        @return Whether any token was parsed, false when the buffer needs a refill, or at the end
+    */
+    bool parseTokens(int maxTokens, bool isFinal);
+
+    /*
+        Parse the next chunk of the document. Tokens may be split anywhere
+        across chunks.
+
+        @param[in] chunk Next part of the srcML document
+    */
+    void feed(std::string_view chunk);
+
+    /*
+        Parse the next chunk of the document, e.g., from an I/O callback.
+        The data is copied, so is not used after the call returns.
+
+        @param[in] data Next part of the srcML document
+        @param[in] size Number of bytes of data
+    */
+    void feed(const char* data, std::size_t size) {
+        feed(std::string_view(data, size));
+    }
+
+    /*
+        Parse the rest of the document after the last input
+
+        @return Measures of the document
+    */
+    const Facts& finish();
+
+    // measures so far, readable between any calls
+    const Facts& facts() const {
+        return counts;
+    }
+
+    // whether the root element has ended
+    bool isComplete() const {
+        return depth == 0 && counts.unitCount > 0;
+    }
+
+    // srcML parsed by the last read, feed, or finish, valid until the next call
+    std::string_view parsed() const {
+        return lastParsed;
+    }
+
+    /*
+        Reset for a new document, keeping the buffer
+    */
+    void reset();
+
+    /*
+        Record the parse events of each read, feed, or finish, replacing the
+        previous events. The views of the events are into the buffer, and are
+        valid until the next call. A feed of a chunk that does not fit in the
+        buffer, with any incomplete token kept from the last call, takes more
+        than one refill, and records only the events of the last one, so for
+        all of the events of a feed, use chunks much smaller than the buffer.
+
+        @param[in] eventLog Events of the last call, or nullptr to stop recording
+    */
+    void recordEvents(std::vector<ParseEvent>* eventLog) {
+        events = eventLog;
+    }
+
+private:
+    void saveInTagName();
+    void parseBuffer();
+
+    std::string::const_iterator parse(std::string::const_iterator cursor, std::string::const_iterator cursorEnd, bool isFinal);
+
+    Facts counts;
+    int depth = 0;
+    bool inTag = false;
+    bool inXMLComment = false;
+    bool inCDATA = false;
+    int terminatorMatched = 0;
+    int tokenLimit = INT_MAX;
+    std::string_view inTagQName;
+    std::string_view inTagPrefix;
+    std::string_view inTagLocalName;
+    std::string inTagName;
+    std::vector<ParseEvent>* events = nullptr;
+    std::string_view lastParsed;
+    std::string buffer;
+    std::string::const_iterator cursor;
+    std::string::const_iterator cursorEnd;
+};
+
+/*
+    Analyze srcML from an input source
+
+    @param[in] input Source of srcML
+    @return Measures of the srcML
+*/
+Facts analyze(InputSource& input);
+
+/*
+    Analyze srcML in memory
+
+    @param[in] srcML Complete srcML document
+    @return Measures of the srcML
+*/
+Facts analyze(std::string_view srcML);
+
+#endif
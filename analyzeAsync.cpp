@@ -0,0 +1,161 @@
+/*
+    analyzeAsync.cpp
+
+    Asynchronous analysis of srcML on an internal thread pool, with
+    cooperative cancellation and deadlines.
+
+    Each worker thread keeps its own analyzer, with its buffer, warm across
+    analyses.
+*/
+
+#include "analyzeAsync.hpp"
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+namespace {
+
+    /*
+        Fixed pool of worker threads, each with an analyzer
+    */
+    class WorkerPool {
+    public:
+        using Task = std::packaged_task<Facts(Analyzer&)>;
+
+        WorkerPool() {
+            const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 0; i < threads; ++i)
+                workers.emplace_back([this] { work(); });
+        }
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_all();
+            for (auto& worker : workers)
+                worker.join();
+        }
+
+        /*
+            Queue a task for the next free worker
+
+            @param[in] task Analysis with the analyzer of the worker
+            @return Future of the result of the task
+        */
+        std::future<Facts> submit(Task task) {
+            auto result = task.get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            ready.notify_one();
+            return result;
+        }
+
+    private:
+        // worker thread: run queued tasks until the pool is destroyed
+        void work() {
+            Analyzer analyzer;
+            while (true) {
+                Task task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                    if (tasks.empty())
+                        return;
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                analyzer.reset();
+                task(analyzer);
+            }
+        }
+
+        std::deque<Task> tasks;
+        std::mutex mutex;
+        std::condition_variable ready;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+    };
+
+    // pool, started on first use
+    WorkerPool& pool() {
+        static WorkerPool workerPool;
+        return workerPool;
+    }
+
+    /*
+        Throw if the analysis is cancelled or past its deadline
+
+        @param[in] options Cancellation and deadline
+    */
+    void checkCancelled(const AsyncOptions& options) {
+        if (options.cancelled && options.cancelled->load(std::memory_order_relaxed))
+            throw AnalysisCancelled("srcFacts: Analysis cancelled");
+        if (options.deadline != std::chrono::steady_clock::time_point::max()
+            && std::chrono::steady_clock::now() >= options.deadline)
+            throw AnalysisCancelled("srcFacts: Analysis deadline exceeded");
+    }
+
+    /*
+        Analyze all of the input, checking for cancellation before each refill
+
+        @param[in,out] analyzer Analyzer, reset for a new document
+        @param[in] input Source of srcML
+        @param[in] options Cancellation and deadline
+        @return Measures of the srcML
+    */
+    Facts analyzeCancellable(Analyzer& analyzer, InputSource& input, const AsyncOptions& options) {
+        do {
+            checkCancelled(options);
+        } while (analyzer.read(input) > 0);
+        return analyzer.finish();
+    }
+
+    /*
+        Input from memory owned by the source
+    */
+    class OwnedStringSource : public InputSource {
+    public:
+        explicit OwnedStringSource(std::string input) : data(std::move(input)), source(data) {}
+        OwnedStringSource(const OwnedStringSource&) = delete;
+        OwnedStringSource& operator=(const OwnedStringSource&) = delete;
+
+        int read(char* buffer, int size) override {
+            return source.read(buffer, size);
+        }
+
+    private:
+        std::string data;
+        StringSource source;
+    };
+}
+
+/*
+    Analyze srcML from an input source on the thread pool
+
+    @param[in] input Source of srcML, owned by the analysis
+    @param[in] options Cancellation and deadline
+    @return Future of the measures, with a ParseError or AnalysisCancelled exception on failure
+*/
+std::future<Facts> analyzeAsync(std::unique_ptr<InputSource> input, AsyncOptions options) {
+    return pool().submit(WorkerPool::Task([source = std::move(input), options = std::move(options)](Analyzer& analyzer) {
+        return analyzeCancellable(analyzer, *source, options);
+    }));
+}
+
+/*
+    Analyze srcML in memory on the thread pool
+
+    @param[in] srcML Complete srcML document, owned by the analysis
+    @param[in] options Cancellation and deadline
+    @return Future of the measures, with a ParseError or AnalysisCancelled exception on failure
+*/
+std::future<Facts> analyzeAsync(std::string srcML, AsyncOptions options) {
+    return analyzeAsync(std::make_unique<OwnedStringSource>(std::move(srcML)), std::move(options));
+}
@@ -0,0 +1,57 @@
+/*
+    analyzeAsync.hpp
+
+    Asynchronous analysis of srcML on an internal thread pool, with
+    cooperative cancellation and deadlines.
+*/
+
+#ifndef INCLUDED_ANALYZEASYNC_HPP
+#define INCLUDED_ANALYZEASYNC_HPP
+
+#include "analyze.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+
+/*
+    Analysis abandoned by cancellation or its deadline
+*/
+class AnalysisCancelled : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/*
+    Options of an asynchronous analysis. Cancellation and the deadline are
+    checked before each refill of the buffer, so a blocking read of the
+    input is not interrupted.
+*/
+struct AsyncOptions {
+    // set to true to cancel the analysis
+    std::shared_ptr<std::atomic<bool>> cancelled;
+
+    // time to abandon the analysis, none by default
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+};
+
+/*
+    Analyze srcML from an input source on the thread pool
+
+    @param[in] input Source of srcML, owned by the analysis
+    @param[in] options Cancellation and deadline
+    @return Future of the measures, with a ParseError or AnalysisCancelled exception on failure
+*/
+std::future<Facts> analyzeAsync(std::unique_ptr<InputSource> input, AsyncOptions options = AsyncOptions());
+
+/*
+    Analyze srcML in memory on the thread pool
+
+    @param[in] srcML Complete srcML document, owned by the analysis
+    @param[in] options Cancellation and deadline
+    @return Future of the measures, with a ParseError or AnalysisCancelled exception on failure
+*/
+std::future<Facts> analyzeAsync(std::string srcML, AsyncOptions options = AsyncOptions());
+
+#endif
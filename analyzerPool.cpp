@@ -0,0 +1,73 @@
+/*
+    analyzerPool.cpp
+
+    Lock-free pool of reusable analyzers.
+
+    Each slot is claimed with a single compare-and-swap, so there is no
+    list to corrupt and no ABA problem. The analyzer of a slot is only
+    touched by the thread holding the slot.
+*/
+
+#include "analyzerPool.hpp"
+#include <thread>
+#include <algorithm>
+#include <functional>
+
+AnalyzerPool::AnalyzerPool(int size)
+    : slots(new Slot[size]), size(size) {
+}
+
+/*
+    Analyzer for a new document
+
+    @return Lease of an analyzer, reset for a new document
+*/
+AnalyzerPool::Lease AnalyzerPool::acquire() {
+    // start at a slot based on the thread, so threads rarely contend for a slot
+    const int start = static_cast<int>(std::hash<std::thread::id>()(std::this_thread::get_id()) % size);
+    for (int i = 0; i < size; ++i) {
+        Slot& slot = slots[(start + i) % size];
+        bool expected = false;
+        if (!slot.inUse.load(std::memory_order_relaxed)
+            && slot.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            if (slot.analyzer) {
+                slot.analyzer->reset();
+            } else {
+                try {
+                    slot.analyzer = std::make_unique<Analyzer>();
+                } catch (...) {
+                    slot.inUse.store(false, std::memory_order_release);
+                    throw;
+                }
+            }
+            return Lease(&slot, nullptr);
+        }
+    }
+    return Lease(nullptr, std::make_unique<Analyzer>());
+}
+
+AnalyzerPool::Lease::Lease(Slot* slot, std::unique_ptr<Analyzer> temporary)
+    : slot(slot), temporary(std::move(temporary)), analyzer(slot ? slot->analyzer.get() : this->temporary.get()) {
+}
+
+AnalyzerPool::Lease::Lease(Lease&& other) noexcept
+    : slot(other.slot), temporary(std::move(other.temporary)), analyzer(other.analyzer) {
+    other.slot = nullptr;
+    other.analyzer = nullptr;
+}
+
+// return the analyzer to the pool
+AnalyzerPool::Lease::~Lease() {
+    if (slot)
+        slot->inUse.store(false, std::memory_order_release);
+}
+
+/*
+    Pool shared by the library, with a slot per hardware thread
+
+    @return Pool of analyzers
+*/
+AnalyzerPool& analyzerPool() {
+    static AnalyzerPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    return pool;
+}
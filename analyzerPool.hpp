@@ -0,0 +1,79 @@
+/*
+    analyzerPool.hpp
+
+    Lock-free pool of reusable analyzers, so that analyzing small inputs
+    does not allocate and clear a new buffer each time.
+*/
+
+#ifndef INCLUDED_ANALYZERPOOL_HPP
+#define INCLUDED_ANALYZERPOOL_HPP
+
+#include "analyze.hpp"
+#include <atomic>
+#include <memory>
+
+/*
+    Fixed number of analyzers, each created on first use and kept for
+    reuse. When all are in use, a temporary analyzer is created.
+
+    Reuse saves the allocation and clearing of the buffer, the main cost
+    of a small input. It is not free of allocation: the Facts returned by
+    analyze() are a copy, with its url, and a tag name split by a refill
+    is copied into a string that only grows past its longest so far.
+*/
+class AnalyzerPool {
+public:
+    explicit AnalyzerPool(int size);
+    AnalyzerPool(const AnalyzerPool&) = delete;
+    AnalyzerPool& operator=(const AnalyzerPool&) = delete;
+
+    struct Slot {
+        std::atomic<bool> inUse{false};
+        std::unique_ptr<Analyzer> analyzer;
+    };
+
+    /*
+        Exclusive use of an analyzer, returned to the pool on destruction
+    */
+    class Lease {
+    public:
+        Lease(Slot* slot, std::unique_ptr<Analyzer> temporary);
+        Lease(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        ~Lease();
+
+        Analyzer& operator*() const {
+            return *analyzer;
+        }
+
+        Analyzer* operator->() const {
+            return analyzer;
+        }
+
+    private:
+        Slot* slot;
+        std::unique_ptr<Analyzer> temporary;
+        Analyzer* analyzer;
+    };
+
+    /*
+        Analyzer for a new document
+
+        @return Lease of an analyzer, reset for a new document
+    */
+    Lease acquire();
+
+private:
+    std::unique_ptr<Slot[]> slots;
+    int size;
+};
+
+/*
+    Pool shared by the library, with a slot per hardware thread
+
+    @return Pool of analyzers
+*/
+AnalyzerPool& analyzerPool();
+
+#endif
@@ -0,0 +1,134 @@
+/*
+    callGraph.cpp
+
+    Call graph of srcML, from the name of each function to the names it calls.
+*/
+
+#include "callGraph.hpp"
+#include <algorithm>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+CallGraph::CallGraph() {
+    // id 0 is for unnamed functions
+    nameId(""sv);
+}
+
+/*
+    Id of an interned name, new names get the next id
+
+    @param[in] name Name
+    @return Id of the name
+*/
+uint32_t CallGraph::nameId(std::string_view name) {
+    // interned names are unique, so the address identifies the name
+    const std::string_view interned = arena.intern(name);
+    const auto result = ids.try_emplace(interned.data(), static_cast<uint32_t>(names.size()));
+    if (result.second)
+        names.push_back(interned);
+    return result.first->second;
+}
+
+/*
+    Update the call graph with the next parse event
+
+    @param[in] event Parse event
+*/
+void CallGraph::event(const ParseEvent& event) {
+    switch (event.type) {
+    case ParseEvent::START_TAG:
+        ++depth;
+        if (!event.prefix.empty())
+            break;
+        if (event.name == "function"sv || event.name == "constructor"sv || event.name == "destructor"sv) {
+            scopes.push_back({ depth, false, false, 0 });
+        } else if (event.name == "call"sv) {
+            scopes.push_back({ depth, true, false, 0 });
+        } else if (event.name == "name"sv && nameDepth == 0 && !scopes.empty()
+            && !scopes.back().hasName && scopes.back().depth == depth - 1) {
+            // the name of a function or call is its first name child, including any nested names
+            nameDepth = depth;
+            nameText.clear();
+        }
+        break;
+    case ParseEvent::CHARACTERS:
+        if (nameDepth)
+            nameText.append(event.value);
+        break;
+    case ParseEvent::END_TAG:
+        if (nameDepth == depth) {
+            nameDepth = 0;
+            Scope& scope = scopes.back();
+            scope.hasName = true;
+            scope.name = nameId(nameText);
+            if (scope.isCall) {
+                // caller is the innermost enclosing function
+                const auto caller = std::find_if(std::next(scopes.rbegin()), scopes.rend(),
+                    [](const Scope& s) { return !s.isCall; });
+                if (caller != scopes.rend())
+                    ++edges[(static_cast<uint64_t>(caller->name) << 32) | scope.name];
+            }
+        } else if (!scopes.empty() && scopes.back().depth == depth) {
+            scopes.pop_back();
+        }
+        --depth;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+    Write the edges as CSV, with a header of caller,callee,count
+
+    @param[out] out Output stream
+*/
+void CallGraph::writeCSV(std::ostream& out) const {
+    // quote names with CSV special characters, doubling quotes
+    const auto field = [&out](std::string_view name) {
+        if (name.find_first_of(",\"\n\r") == std::string_view::npos) {
+            out << name;
+            return;
+        }
+        out << '"';
+        for (const char c : name) {
+            if (c == '"')
+                out << '"';
+            out << c;
+        }
+        out << '"';
+    };
+    out << "caller,callee,count\n";
+    for (const auto& edge : edges) {
+        field(names[edge.first >> 32]);
+        out << ',';
+        field(names[edge.first & 0xFFFFFFFF]);
+        out << ',' << edge.second << '\n';
+    }
+}
+
+/*
+    Write the edges in binary, in native byte order:
+    "SFCG", uint32 name count, names as uint32 length and bytes,
+    uint32 edge count, and edges as uint32 caller, callee, and count
+
+    @param[out] out Output stream
+*/
+void CallGraph::writeBinary(std::ostream& out) const {
+    const auto writeUInt32 = [&out](uint32_t n) {
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    };
+    out.write("SFCG", 4);
+    writeUInt32(static_cast<uint32_t>(names.size()));
+    for (const std::string_view name : names) {
+        writeUInt32(static_cast<uint32_t>(name.size()));
+        out.write(name.data(), name.size());
+    }
+    writeUInt32(static_cast<uint32_t>(edges.size()));
+    for (const auto& edge : edges) {
+        writeUInt32(static_cast<uint32_t>(edge.first >> 32));
+        writeUInt32(static_cast<uint32_t>(edge.first & 0xFFFFFFFF));
+        writeUInt32(edge.second);
+    }
+}
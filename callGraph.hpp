@@ -0,0 +1,78 @@
+/*
+    callGraph.hpp
+
+    Call graph of srcML, from the name of each function to the names it calls.
+*/
+
+#ifndef INCLUDED_CALLGRAPH_HPP
+#define INCLUDED_CALLGRAPH_HPP
+
+#include "parseEvent.hpp"
+#include "stringArena.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+#include <cstdint>
+
+/*
+    Caller to callee edges with counts, built in a single pass over the
+    parse events. The caller is the name of the enclosing function,
+    constructor, or destructor, and the callee is the name of the call.
+    Calls outside of a function are not included.
+*/
+class CallGraph {
+public:
+    CallGraph();
+
+    /*
+        Update the call graph with the next parse event
+
+        @param[in] event Parse event
+    */
+    void event(const ParseEvent& event);
+
+    /*
+        Write the edges as CSV, with a header of caller,callee,count
+
+        @param[out] out Output stream
+    */
+    void writeCSV(std::ostream& out) const;
+
+    /*
+        Write the edges in binary, in native byte order:
+        "SFCG", uint32 name count, names as uint32 length and bytes,
+        uint32 edge count, and edges as uint32 caller, callee, and count
+
+        @param[out] out Output stream
+    */
+    void writeBinary(std::ostream& out) const;
+
+    // number of distinct edges
+    std::size_t size() const {
+        return edges.size();
+    }
+
+private:
+    uint32_t nameId(std::string_view name);
+
+    // function, constructor, destructor, or call with its name
+    struct Scope {
+        int depth;
+        bool isCall;
+        bool hasName;
+        uint32_t name;
+    };
+
+    StringArena arena;
+    std::unordered_map<const char*, uint32_t> ids;
+    std::vector<std::string_view> names;
+    std::unordered_map<uint64_t, uint32_t> edges;
+    std::vector<Scope> scopes;
+    int depth = 0;
+    int nameDepth = 0;
+    std::string nameText;
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+    complexity.cpp
+
+    Cyclomatic complexity of each function in srcML.
+*/
+
+#include "complexity.hpp"
+#include <algorithm>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+/*
+    Update the complexity with the next parse event
+
+    @param[in] event Parse event
+*/
+void Complexity::event(const ParseEvent& event) {
+    switch (event.type) {
+    case ParseEvent::START_TAG:
+        ++depth;
+        inUnitTag = false;
+        if (!event.prefix.empty())
+            break;
+        if (event.name == "unit"sv) {
+            // each unit, including the root of an archive, gets the next unit id
+            filenames.emplace_back();
+            line = 1;
+            inUnitTag = true;
+        } else if (event.name == "function"sv || event.name == "constructor"sv || event.name == "destructor"sv) {
+            openFunctions.emplace_back(depth, functionList.size());
+            functionList.push_back({ static_cast<uint32_t>(filenames.empty() ? 0 : filenames.size() - 1), line, 1, "" });
+        } else if (openFunctions.empty()) {
+            break;
+        } else if (event.name == "name"sv && nameDepth == 0 && openFunctions.back().first == depth - 1
+            && functionList[openFunctions.back().second].name.empty()) {
+            // the name of a function is its first name child, including any nested names
+            nameDepth = depth;
+        } else if (event.name == "if"sv || event.name == "while"sv || event.name == "for"sv || event.name == "foreach"sv
+            || event.name == "do"sv || event.name == "case"sv || event.name == "catch"sv || event.name == "ternary"sv) {
+            ++functionList[openFunctions.back().second].complexity;
+        } else if (event.name == "operator"sv) {
+            inOperator = true;
+            operatorText.clear();
+        }
+        break;
+    case ParseEvent::ATTRIBUTE:
+        if (inUnitTag && event.prefix.empty() && event.name == "filename"sv)
+            filenames.back() = event.value;
+        break;
+    case ParseEvent::CHARACTERS:
+    case ParseEvent::CDATA:
+        if (nameDepth)
+            functionList[openFunctions.back().second].name.append(event.value);
+        else if (inOperator)
+            operatorText.append(event.value);
+        line += static_cast<uint32_t>(std::count(event.value.cbegin(), event.value.cend(), '\n'));
+        break;
+    case ParseEvent::END_TAG:
+        inUnitTag = false;
+        if (nameDepth == depth) {
+            nameDepth = 0;
+        } else if (inOperator) {
+            inOperator = false;
+            if (operatorText == "&&"sv || operatorText == "||"sv)
+                ++functionList[openFunctions.back().second].complexity;
+        } else if (!openFunctions.empty() && openFunctions.back().first == depth) {
+            openFunctions.pop_back();
+        }
+        --depth;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+    Write the complexity of each function as CSV, with a header of
+    filename,function,line,complexity, in order of the functions
+
+    @param[out] out Output stream
+*/
+void Complexity::writeCSV(std::ostream& out) const {
+    // quote names with CSV special characters, doubling quotes
+    const auto field = [&out](std::string_view name) {
+        if (name.find_first_of(",\"\n\r") == std::string_view::npos) {
+            out << name;
+            return;
+        }
+        out << '"';
+        for (const char c : name) {
+            if (c == '"')
+                out << '"';
+            out << c;
+        }
+        out << '"';
+    };
+    out << "filename,function,line,complexity\n";
+    for (const Function& function : functionList) {
+        field(function.unit < filenames.size() ? filenames[function.unit] : std::string());
+        out << ',';
+        field(function.name);
+        out << ',' << function.line << ',' << function.complexity << '\n';
+    }
+}
@@ -0,0 +1,69 @@
+/*
+    complexity.hpp
+
+    Cyclomatic complexity of each function in srcML.
+*/
+
+#ifndef INCLUDED_COMPLEXITY_HPP
+#define INCLUDED_COMPLEXITY_HPP
+
+#include "parseEvent.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <ostream>
+#include <cstdint>
+
+/*
+    Cyclomatic complexity of each function, constructor, and destructor,
+    built in a single pass over the parse events. The complexity is one
+    more than the number of decisions: if, else if, while, for, foreach,
+    do, case, catch, ternary, and the operators && and ||. Decisions in a
+    lambda count for its enclosing function.
+*/
+class Complexity {
+public:
+    // complexity of a function
+    struct Function {
+        uint32_t unit;
+        uint32_t line;
+        int complexity;
+        std::string name;
+    };
+
+    /*
+        Update the complexity with the next parse event
+
+        @param[in] event Parse event
+    */
+    void event(const ParseEvent& event);
+
+    /*
+        Write the complexity of each function as CSV, with a header of
+        filename,function,line,complexity, in order of the functions
+
+        @param[out] out Output stream
+    */
+    void writeCSV(std::ostream& out) const;
+
+    // functions in order of their start
+    const std::vector<Function>& functions() const {
+        return functionList;
+    }
+
+private:
+    std::vector<Function> functionList;
+    std::vector<std::string> filenames;
+
+    // open functions, as the depth and index of each
+    std::vector<std::pair<int, std::size_t>> openFunctions;
+    int depth = 0;
+    uint32_t line = 1;
+    bool inUnitTag = false;
+    int nameDepth = 0;
+    bool inOperator = false;
+    std::string operatorText;
+};
+
+#endif
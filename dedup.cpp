@@ -0,0 +1,114 @@
+/*
+    dedup.cpp
+
+    Deduplication mode for srcFacts, with measures of the unique units.
+
+    Vendored and copied files make identical units common in archives. A
+    quick scan splits the archive into units, and the content of each unit
+    after its start tag, which has the filename, is looked up in a hash
+    table of the units so far. Only the first of identical units is
+    analyzed, and its measures are reused for the copies. The text of the
+    root unit between the units is analyzed once, and is in both totals.
+*/
+
+#include "dedup.hpp"
+#include "unitScan.hpp"
+#include <iostream>
+#include <iomanip>
+#include <locale>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <errno.h>
+
+/*
+    Analyze each distinct unit of a srcML archive once, and report the
+    totals of all units and of the unique units
+
+    @param[in] fd File descriptor of the srcML, mapped if it is a file
+    @return 0 on success, 1 on error
+*/
+int dedup(int fd) {
+    InputData input(fd);
+    if (input.isError) {
+        std::cerr << "srcFacts: Unable to read input: " << strerror(errno) << '\n';
+        return 1;
+    }
+    const std::vector<std::string_view> units = findUnits(input.data);
+
+    // index of the first unit with the same content, keyed by the content in the input
+    std::unordered_map<std::string_view, std::size_t> firstUnits(units.size());
+    std::vector<std::size_t> unitResult(units.size());
+    UnitAnalyses results;
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        const std::string_view unit = units[i];
+        const auto first = firstUnits.try_emplace(unit.substr(startTagEnd(unit)), results.size());
+        if (first.second)
+            results.submit(unit);
+        unitResult[i] = first.first->second;
+    }
+
+    // on an error, the rest of the analyses are cancelled before the input is released
+    std::vector<Facts> facts;
+    facts.reserve(results.size());
+    Facts outside;
+    try {
+        while (results.size() > 0)
+            facts.push_back(results.next());
+        outside = analyze(outsideUnits(input.data, units));
+    } catch (const ParseError& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    // totals of all the units, and of the unique units
+    Facts total;
+    Facts unique;
+    const auto add = [](Facts& sum, const Facts& unit) {
+        sum.totalBytes += unit.totalBytes;
+        sum.textsize += unit.textsize;
+        sum.loc += unit.loc;
+        sum.exprCount += unit.exprCount;
+        sum.functionCount += unit.functionCount;
+        sum.classCount += unit.classCount;
+        sum.unitCount += unit.unitCount;
+        sum.declCount += unit.declCount;
+        sum.commentCount += unit.commentCount;
+    };
+    for (std::size_t i = 0; i < units.size(); ++i) {
+        add(total, facts[unitResult[i]]);
+        // a copy has its own size, since its start tag differs
+        total.totalBytes += static_cast<long>(units[i].size()) - facts[unitResult[i]].totalBytes;
+    }
+    for (const Facts& unit : facts)
+        add(unique, unit);
+
+    // the text between the units, e.g., newlines, is in the root unit, so is in both totals
+    for (Facts* sum : { &total, &unique }) {
+        sum->textsize += outside.textsize;
+        sum->loc += outside.loc;
+        sum->commentCount += outside.commentCount;
+    }
+
+    const int valueWidth = std::max(6, static_cast<int>(std::log10(std::max<long>(total.totalBytes, 1)) * 1.3 + 1));
+    std::cout.imbue(std::locale{""});
+    std::cout << "# srcFacts: " << unique.unitCount << " unique of " << total.unitCount << " units\n";
+    std::cout << "| Measure      | " << std::setw(valueWidth + 2) << "All |" << ' ' << std::setw(valueWidth + 3) << "Unique |\n";
+    std::cout << "|:-------------|-" << std::setw(valueWidth + 2) << std::setfill('-') << ":|" << '-' << std::setw(valueWidth + 3) << ":|\n" << std::setfill(' ');
+    const auto row = [valueWidth](const char* measure, long all, long distinct) {
+        std::cout << "| " << measure << " | " << std::setw(valueWidth) << all << " | " << std::setw(valueWidth) << distinct << " |\n";
+    };
+    row("Unit bytes  ", total.totalBytes, unique.totalBytes);
+    row("Characters  ", total.textsize, unique.textsize);
+    row("Files       ", total.unitCount, unique.unitCount);
+    row("LOC         ", total.loc, unique.loc);
+    row("Classes     ", total.classCount, unique.classCount);
+    row("Functions   ", total.functionCount, unique.functionCount);
+    row("Declarations", total.declCount, unique.declCount);
+    row("Expressions ", total.exprCount, unique.exprCount);
+    row("Comments    ", total.commentCount, unique.commentCount);
+    return 0;
+}
@@ -0,0 +1,19 @@
+/*
+    dedup.hpp
+
+    Deduplication mode for srcFacts, with measures of the unique units.
+*/
+
+#ifndef INCLUDED_DEDUP_HPP
+#define INCLUDED_DEDUP_HPP
+
+/*
+    Analyze each distinct unit of a srcML archive once, and report the
+    totals of all units and of the unique units
+
+    @param[in] fd File descriptor of the srcML, mapped if it is a file
+    @return 0 on success, 1 on error
+*/
+int dedup(int fd);
+
+#endif
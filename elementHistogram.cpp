@@ -0,0 +1,51 @@
+/*
+    elementHistogram.cpp
+
+    Histogram of the elements of srcML, from each element name to its count.
+*/
+
+#include "elementHistogram.hpp"
+#include <algorithm>
+#include <vector>
+#include <utility>
+
+/*
+    Update the histogram with the next parse event
+
+    @param[in] event Parse event
+*/
+void ElementHistogram::event(const ParseEvent& event) {
+    if (event.type != ParseEvent::START_TAG)
+        return;
+    std::string_view name = event.name;
+    if (!event.prefix.empty()) {
+        qName.assign(event.prefix);
+        qName += ':';
+        qName.append(event.name);
+        name = qName;
+    }
+    const auto found = counts.find(name);
+    if (found != counts.end()) {
+        ++found->second;
+        return;
+    }
+
+    // names are views into the buffer, so keep a copy as the key
+    counts.emplace(arena.intern(name), 1);
+}
+
+/*
+    Write the counts as CSV, with a header of element,count, in order
+    of decreasing count
+
+    @param[out] out Output stream
+*/
+void ElementHistogram::writeCSV(std::ostream& out) const {
+    std::vector<std::pair<std::string_view, long>> sorted(counts.cbegin(), counts.cend());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    out << "element,count\n";
+    for (const auto& count : sorted)
+        out << count.first << ',' << count.second << '\n';
+}
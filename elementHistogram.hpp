@@ -0,0 +1,49 @@
+/*
+    elementHistogram.hpp
+
+    Histogram of the elements of srcML, from each element name to its count.
+*/
+
+#ifndef INCLUDED_ELEMENTHISTOGRAM_HPP
+#define INCLUDED_ELEMENTHISTOGRAM_HPP
+
+#include "parseEvent.hpp"
+#include "stringArena.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <ostream>
+
+/*
+    Count of each element, by qualified name, e.g., "if" or "cpp:include",
+    built in a single pass over the parse events
+*/
+class ElementHistogram {
+public:
+    /*
+        Update the histogram with the next parse event
+
+        @param[in] event Parse event
+    */
+    void event(const ParseEvent& event);
+
+    /*
+        Write the counts as CSV, with a header of element,count, in order
+        of decreasing count
+
+        @param[out] out Output stream
+    */
+    void writeCSV(std::ostream& out) const;
+
+    // number of distinct elements
+    std::size_t size() const {
+        return counts.size();
+    }
+
+private:
+    StringArena arena;
+    std::unordered_map<std::string_view, long> counts;
+    std::string qName;
+};
+
+#endif
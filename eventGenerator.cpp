@@ -0,0 +1,105 @@
+/*
+    eventGenerator.cpp
+
+    Generator of the parse events of a srcML document, pulled one at a time.
+
+    A C++17 equivalent of a coroutine generator: the analyzer parses a
+    small step of tokens at a time, and the generator yields their events
+    in order, parsing the next step only when they are used up. A step of
+    a few tokens, rather than one, amortizes the call into the parser. The
+    events of one step are parsed ahead, so available() tells the caller
+    when the next call refills the buffer.
+*/
+
+#include "eventGenerator.hpp"
+
+namespace {
+
+    // tokens parsed at each step
+    const int STEP_TOKENS = 64;
+}
+
+/*
+    Events of srcML read from an input source as needed
+
+    @param[in] input Source of srcML
+*/
+EventGenerator::EventGenerator(InputSource& input)
+    : input(&input) {
+    analyzer.recordEvents(&events);
+}
+
+/*
+    Events of srcML fed by the caller
+*/
+EventGenerator::EventGenerator() {
+    analyzer.recordEvents(&events);
+}
+
+/*
+    Parse the next step of tokens with events in the buffer, without a refill
+
+    @return Whether there are events
+*/
+bool EventGenerator::parseBuffered() {
+    while (events.empty() && analyzer.parseTokens(STEP_TOKENS, isAtEnd)) {
+    }
+    return !events.empty();
+}
+
+/*
+    Next parse event. The views of the event are valid until the next call.
+
+    @return Next event, or nullptr at the end of the document or when needsInput()
+*/
+const ParseEvent* EventGenerator::next() {
+    if (position == events.size()) {
+        events.clear();
+        position = 0;
+        while (!parseBuffered()) {
+            if (isFinished)
+                return nullptr;
+            if (isAtEnd) {
+                isFinished = true;
+                return nullptr;
+            }
+            int bytesRead = 0;
+            if (input) {
+                bytesRead = analyzer.refill(*input);
+            } else if (!pending.empty()) {
+                StringSource chunk(pending);
+                bytesRead = analyzer.refill(chunk);
+                pending.remove_prefix(bytesRead);
+            } else if (!isInputFinished) {
+                return nullptr;
+            }
+            if (bytesRead == 0)
+                isAtEnd = true;
+        }
+    }
+    current = events[position++];
+
+    // parse ahead within the buffer, so available() is 0 only before a refill
+    if (position == events.size()) {
+        events.clear();
+        position = 0;
+        parseBuffered();
+    }
+    return &current;
+}
+
+/*
+    Feed the next chunk of srcML, when needsInput()
+
+    @param[in] chunk Next part of the srcML document, used until needsInput()
+*/
+void EventGenerator::feed(std::string_view chunk) {
+    pending = chunk;
+}
+
+/*
+    Mark the end of the fed srcML
+*/
+void EventGenerator::finish() {
+    isInputFinished = true;
+}
@@ -0,0 +1,139 @@
+/*
+    eventGenerator.hpp
+
+    Generator of the parse events of a srcML document, pulled one at a time,
+    e.g., in a range-based for loop.
+*/
+
+#ifndef INCLUDED_EVENTGENERATOR_HPP
+#define INCLUDED_EVENTGENERATOR_HPP
+
+#include "analyze.hpp"
+#include "parseEvent.hpp"
+#include <vector>
+#include <iterator>
+#include <cstddef>
+
+/*
+    Generator of parse events. Parsing is suspended after each small step
+    of tokens, and resumed when their events are used up, so events are
+    yielded as they are parsed. At a buffer refill, the input is either read from an input
+    source, or, for asynchronous input, fed by the caller when the generator
+    needs more.
+*/
+class EventGenerator {
+public:
+    /*
+        Events of srcML read from an input source as needed
+
+        @param[in] input Source of srcML
+    */
+    explicit EventGenerator(InputSource& input);
+
+    /*
+        Events of srcML fed by the caller
+    */
+    EventGenerator();
+
+    /*
+        Next parse event. The views of the event are valid until the next call.
+
+        @return Next event, or nullptr at the end of the document or when needsInput()
+    */
+    const ParseEvent* next();
+
+    /*
+        Feed the next chunk of srcML, when needsInput()
+
+        @param[in] chunk Next part of the srcML document, used until needsInput()
+    */
+    void feed(std::string_view chunk);
+
+    /*
+        Mark the end of the fed srcML
+    */
+    void finish();
+
+    // number of parsed events before the next refill, after which the views of earlier events are invalid,
+    // so 0 when the next call refills the buffer
+    std::size_t available() const {
+        return events.size() - position;
+    }
+
+    // whether the generator is waiting for a fed chunk
+    bool needsInput() const {
+        return !input && pending.empty() && !isInputFinished;
+    }
+
+    // measures so far
+    const Facts& facts() const {
+        return analyzer.facts();
+    }
+
+    /*
+        Input iterator over the events
+    */
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = ParseEvent;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ParseEvent*;
+        using reference = const ParseEvent&;
+
+        iterator(EventGenerator* generator, const ParseEvent* event) : generator(generator), event(event) {}
+
+        reference operator*() const {
+            return *event;
+        }
+
+        pointer operator->() const {
+            return event;
+        }
+
+        iterator& operator++() {
+            event = generator->next();
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const {
+            return event == other.event;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return event != other.event;
+        }
+
+    private:
+        EventGenerator* generator;
+        const ParseEvent* event;
+    };
+
+    // first event, which starts parsing
+    iterator begin() {
+        return iterator(this, next());
+    }
+
+    iterator end() {
+        return iterator(this, nullptr);
+    }
+
+private:
+    bool parseBuffered();
+
+    Analyzer analyzer;
+    InputSource* input = nullptr;
+    std::string_view pending;
+    bool isInputFinished = false;
+    bool isAtEnd = false;
+    bool isFinished = false;
+
+    // events of the step of tokens parsed ahead
+    std::vector<ParseEvent> events;
+    std::size_t position = 0;
+
+    // event yielded by the last call
+    ParseEvent current{};
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+    eventHandlers.hpp
+
+    Fan-out of the parse events to several analyses in a single pass.
+*/
+
+#ifndef INCLUDED_EVENTHANDLERS_HPP
+#define INCLUDED_EVENTHANDLERS_HPP
+
+#include "parseEvent.hpp"
+#include <tuple>
+
+/*
+    Handler of the parse events that passes each event to all of its
+    handlers, in order. A handler is any type with event(const ParseEvent&),
+    e.g., CallGraph, and is called directly, with no virtual dispatch. A null
+    handler is skipped, so analyses can be chosen at run time. EventHandlers
+    is itself a handler, so fan-outs can be nested.
+
+        EventHandlers handlers(&callGraph, &histogram);
+        for (const ParseEvent& event : events)
+            handlers.event(event);
+*/
+template <typename... Handlers>
+class EventHandlers {
+public:
+    /*
+        @param[in] handlers Handlers of the events, or nullptr to skip
+    */
+    explicit EventHandlers(Handlers*... handlers)
+        : handlers(handlers...) {}
+
+    /*
+        Pass the next parse event to each handler
+
+        @param[in] event Parse event
+    */
+    void event(const ParseEvent& event) {
+        std::apply([&event](Handlers*... handler) {
+            ((handler ? static_cast<void>(handler->event(event)) : static_cast<void>(0)), ...);
+        }, handlers);
+    }
+
+    // whether there are any handlers
+    bool empty() const {
+        return std::apply([](Handlers*... handler) {
+            return ((handler == nullptr) && ...);
+        }, handlers);
+    }
+
+private:
+    std::tuple<Handlers*...> handlers;
+};
+
+#endif
@@ -0,0 +1,177 @@
+/*
+    eventStream.cpp
+
+    Compact binary stream of the parse events, for downstream tools to
+    use one tokenization of the srcML instead of parsing it again.
+*/
+
+#include "eventStream.hpp"
+#include <algorithm>
+
+namespace {
+
+    const uint64_t EVENT_STREAM_VERSION = 2;
+
+    // events are written in blocks of this size, or larger for a longer string
+    const std::size_t EVENT_STREAM_BLOCK = 256 * 1024;
+}
+
+/*
+    @param[out] out Output stream of the events
+*/
+EventStreamWriter::EventStreamWriter(std::ostream& out)
+    : out(out), buffer(EVENT_STREAM_BLOCK, '\0') {
+    std::copy_n("SFEV", 4, &buffer[0]);
+    used = 4;
+    writeVarint(EVENT_STREAM_VERSION);
+}
+
+/*
+    Id of a qualified name, with a NAME record for a new name
+
+    @param[in] prefix Prefix of the name, or empty
+    @param[in] name Local name
+    @return Id of the name
+*/
+uint32_t EventStreamWriter::nameId(std::string_view prefix, std::string_view name) {
+    std::string_view key = name;
+    if (!prefix.empty()) {
+        qName.assign(prefix);
+        qName += ':';
+        qName.append(name);
+        key = qName;
+    }
+    // few distinct names, so most are in the cache
+    CachedName& cached = nameCache[(key.size() * 31 + (key.empty() ? 0 : key.front() + key.back() * 7)) % nameCache.size()];
+    if (cached.name == key)
+        return cached.id;
+    const auto found = ids.find(key);
+    if (found != ids.end()) {
+        cached = { found->first, found->second };
+        return found->second;
+    }
+
+    // names are views into the buffer, so keep a copy as the key
+    const uint32_t id = static_cast<uint32_t>(ids.size());
+    const std::string_view interned = arena.intern(key);
+    ids.emplace(interned, id);
+    cached = { interned, id };
+    buffer[used++] = static_cast<char>(NAME);
+    writeString(key);
+    reserve(0);
+    return id;
+}
+
+/*
+    Append an unsigned LEB128 varint
+
+    @param[in] n Integer
+*/
+void EventStreamWriter::writeVarint(uint64_t n) {
+    char* next = &buffer[used];
+    while (n >= 0x80) {
+        *next++ = static_cast<char>((n & 0x7F) | 0x80);
+        n >>= 7;
+    }
+    *next++ = static_cast<char>(n);
+    used = next - buffer.data();
+}
+
+/*
+    Append a string as its varint length and bytes
+
+    @param[in] s String
+*/
+void EventStreamWriter::writeString(std::string_view s) {
+    writeVarint(s.size());
+    reserve(s.size());
+    std::copy(s.begin(), s.end(), &buffer[used]);
+    used += s.size();
+}
+
+/*
+    Make room in the buffer for a record, writing the buffered records when full
+
+    @param[in] size Number of bytes beyond the fixed-size fields
+*/
+void EventStreamWriter::reserve(std::size_t size) {
+    if (used + size + MAX_FIELDS_SIZE <= buffer.size())
+        return;
+    out.write(buffer.data(), used);
+    used = 0;
+    if (size + MAX_FIELDS_SIZE > buffer.size())
+        buffer.resize(size + MAX_FIELDS_SIZE);
+}
+
+/*
+    Write the next parse event
+
+    @param[in] event Parse event
+*/
+void EventStreamWriter::event(const ParseEvent& event) {
+    reserve(0);
+    switch (event.type) {
+    case ParseEvent::START_TAG: {
+        const uint32_t id = nameId(event.prefix, event.name);
+        openIds.push_back(id);
+        buffer[used++] = static_cast<char>(event.type);
+        writeVarint(id);
+        writeVarint(openIds.size());
+        break;
+    }
+    case ParseEvent::END_TAG: {
+        // the end tag matches the innermost start tag
+        const uint32_t id = openIds.empty() ? nameId(event.prefix, event.name) : openIds.back();
+        buffer[used++] = static_cast<char>(event.type);
+        writeVarint(id);
+        writeVarint(openIds.size());
+        if (!openIds.empty())
+            openIds.pop_back();
+        break;
+    }
+    case ParseEvent::ATTRIBUTE: {
+        const uint32_t id = nameId(event.prefix, event.name);
+        buffer[used++] = static_cast<char>(event.type);
+        writeVarint(id);
+        writeString(event.value);
+        break;
+    }
+    case ParseEvent::NAMESPACE:
+        buffer[used++] = static_cast<char>(event.type);
+        writeString(event.prefix);
+        writeString(event.value);
+        break;
+    case ParseEvent::CHARACTERS:
+    case ParseEvent::COMMENT:
+    case ParseEvent::CDATA:
+        buffer[used++] = static_cast<char>(event.type);
+        writeVarint(std::count(event.value.begin(), event.value.end(), '\n'));
+        writeString(event.value);
+        break;
+    case ParseEvent::XML_DECLARATION:
+        buffer[used++] = static_cast<char>(event.type);
+        writeString(event.value);
+        break;
+    case ParseEvent::PROCESSING_INSTRUCTION:
+        buffer[used++] = static_cast<char>(event.type);
+        writeString(event.name);
+        writeString(event.value);
+        break;
+    }
+}
+
+/*
+    Write any buffered events, and the END record
+
+    @param[in] status Whether the document was parsed to its end
+    @return Whether all events were written
+*/
+bool EventStreamWriter::finish(Status status) {
+    reserve(0);
+    buffer[used++] = static_cast<char>(END);
+    writeVarint(status);
+    out.write(buffer.data(), used);
+    used = 0;
+    out.flush();
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,99 @@
+/*
+    eventStream.hpp
+
+    Compact binary stream of the parse events, for downstream tools to
+    use one tokenization of the srcML instead of parsing it again.
+*/
+
+#ifndef INCLUDED_EVENTSTREAM_HPP
+#define INCLUDED_EVENTSTREAM_HPP
+
+#include "parseEvent.hpp"
+#include "stringArena.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <array>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+/*
+    Writer of the parse events as a binary stream. Integers are unsigned
+    LEB128 varints, and strings are a varint length and the bytes.
+
+    Stream format:
+    * "SFEV" and a varint version
+    * records, each a type byte and its fields:
+      * NAME: qualified name, "prefix:name" or "name", with the next name id from 0
+      * START_TAG, END_TAG: name id, depth of the element with the root at 1
+      * ATTRIBUTE: name id, value
+      * NAMESPACE: prefix, uri
+      * CHARACTERS, COMMENT, CDATA: newline count, content
+      * XML_DECLARATION: version
+      * PROCESSING_INSTRUCTION: target, data
+      * END: status, COMPLETE (0) at the end of the document, or FAILED (1)
+        when parsing failed
+    The record types are those of ParseEvent::Type, with NAME and END after
+    them. A NAME record comes before the first use of its name id. END is
+    the last record, so a stream without it was cut short.
+*/
+class EventStreamWriter {
+public:
+    // record type of the definition of a name id
+    static const unsigned char NAME = ParseEvent::PROCESSING_INSTRUCTION + 1;
+
+    // record type of the end of the stream
+    static const unsigned char END = NAME + 1;
+
+    // status of the END record
+    enum Status : unsigned char { COMPLETE = 0, FAILED = 1 };
+
+    /*
+        @param[out] out Output stream of the events
+    */
+    explicit EventStreamWriter(std::ostream& out);
+
+    /*
+        Write the next parse event
+
+        @param[in] event Parse event
+    */
+    void event(const ParseEvent& event);
+
+    /*
+        Write any buffered events, and the END record
+
+        @param[in] status Whether the document was parsed to its end
+        @return Whether all events were written
+    */
+    bool finish(Status status = COMPLETE);
+
+private:
+    uint32_t nameId(std::string_view prefix, std::string_view name);
+    void writeVarint(uint64_t n);
+    void writeString(std::string_view s);
+    void reserve(std::size_t size);
+
+    // room for a type byte and varint fields, or a NAME record type
+    static const std::size_t MAX_FIELDS_SIZE = 64;
+
+    std::ostream& out;
+    std::string buffer;
+    std::size_t used = 0;
+    StringArena arena;
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    // direct-mapped cache of the ids of names
+    struct CachedName {
+        std::string_view name;
+        uint32_t id;
+    };
+    std::array<CachedName, 256> nameCache{};
+    std::string qName;
+
+    // ids of the open elements
+    std::vector<uint32_t> openIds;
+};
+
+#endif
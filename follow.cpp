@@ -0,0 +1,182 @@
+/*
+    follow.cpp
+
+    Follow mode for srcFacts, for a srcML file that is still being written.
+
+    Instead of rescanning the file, reading continues from where it stopped,
+    and at the end of the current data, waits with inotify for more.
+*/
+
+#include "follow.hpp"
+#include "analyze.hpp"
+#include "publish.hpp"
+#include <iostream>
+#include <chrono>
+#include <functional>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+
+namespace {
+
+    // set by SIGINT and SIGTERM
+    volatile sig_atomic_t isStopped = 0;
+
+    void stop(int) {
+        isStopped = 1;
+    }
+
+    /*
+        Input from a file that is still being appended to. At the end of the
+        data, waits for the file to change, calling idle at each interval.
+    */
+    class FollowSource : public InputSource {
+    public:
+        /*
+            @param[in] fd File descriptor of the file
+            @param[in] watch inotify file descriptor watching the file
+            @param[in] interval Time between calls of idle while waiting
+            @param[in] idle Called while waiting, returns whether to keep waiting
+        */
+        FollowSource(int fd, int watch, std::chrono::milliseconds interval, std::function<bool()> idle)
+            : fd(fd), watch(watch), interval(interval), idle(std::move(idle)) {}
+
+        int read(char* data, int size) override {
+            while (true) {
+                ssize_t readBytes = 0;
+                while ((readBytes = ::read(fd, data, size)) == -1 && errno == EINTR && !isStopped) {
+                }
+                if (readBytes != 0 || isEnded)
+                    return static_cast<int>(readBytes);
+
+                // wait for the file to grow
+                pollfd watchPoll{ watch, POLLIN, 0 };
+                const int ready = poll(&watchPoll, 1, static_cast<int>(interval.count()));
+                if (!idle())
+                    return 0;
+                if (ready <= 0)
+                    continue;
+                alignas(inotify_event) char events[4096];
+                const ssize_t eventBytes = ::read(watch, events, sizeof(events));
+                for (ssize_t offset = 0; offset < eventBytes;) {
+                    const auto event = reinterpret_cast<const inotify_event*>(events + offset);
+                    // read the rest of a deleted or moved file, then end. A file that is
+                    // still open is not deleted, so an unlink is only a change in its links.
+                    if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF))
+                        isEnded = true;
+                    struct stat status;
+                    if ((event->mask & IN_ATTRIB) && fstat(fd, &status) == 0 && status.st_nlink == 0)
+                        isEnded = true;
+                    offset += sizeof(inotify_event) + event->len;
+                }
+            }
+        }
+
+    private:
+        int fd;
+        int watch;
+        std::chrono::milliseconds interval;
+        std::function<bool()> idle;
+        bool isEnded = false;
+    };
+
+    /*
+        Write the facts so far as a single line
+
+        @param[in] facts Measures of the srcML
+    */
+    void snapshot(const Facts& facts) {
+        std::cout << "bytes=" << facts.totalBytes
+                  << " files=" << facts.files()
+                  << " loc=" << facts.loc
+                  << " classes=" << facts.classCount
+                  << " functions=" << facts.functionCount
+                  << " declarations=" << facts.declCount
+                  << " expressions=" << facts.exprCount
+                  << " comments=" << facts.commentCount << std::endl;
+    }
+}
+
+/*
+    Analyze a srcML file as it grows, waiting with inotify for appended data,
+    with a snapshot of the facts at each interval. Ends at the end of the
+    document, when the file is deleted or moved, or on SIGINT or SIGTERM.
+    A file that ends before the end of the document is an error.
+
+    @param[in] path Path of the srcML file
+    @param[in] interval Seconds between snapshots
+    @param[in] publisher Publisher of the facts after each read, or nullptr
+    @return 0 on success, 1 on error
+*/
+int follow(const char* path, int interval, FactsPublisher* publisher) {
+    const int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "srcFacts: Unable to open " << path << ": " << strerror(errno) << '\n';
+        return 1;
+    }
+    const int watch = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (watch == -1 || inotify_add_watch(watch, path, IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF) == -1) {
+        std::cerr << "srcFacts: Unable to watch " << path << ": " << strerror(errno) << '\n';
+        close(fd);
+        return 1;
+    }
+
+    // stop on a signal, with the facts so far, instead of exiting
+    struct sigaction action{};
+    action.sa_handler = stop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    Analyzer analyzer;
+    const auto snapshotInterval = std::chrono::seconds(interval > 0 ? interval : 1);
+    auto nextSnapshot = std::chrono::steady_clock::now() + snapshotInterval;
+    // snapshot when due, both while reading and while waiting
+    const auto snapshotIfDue = [&]() {
+        const auto now = std::chrono::steady_clock::now();
+        if (now < nextSnapshot)
+            return;
+        snapshot(analyzer.facts());
+        nextSnapshot = now + snapshotInterval;
+    };
+    FollowSource input(fd, watch, std::chrono::milliseconds(200), [&]() {
+        snapshotIfDue();
+        return !isStopped;
+    });
+
+    // complete only at the end of the document, not on a signal or a deleted or moved file
+    int status = 0;
+    PublishedFacts::State state = PublishedFacts::FAILED;
+    try {
+        while (!analyzer.isComplete() && analyzer.read(input) > 0) {
+            snapshotIfDue();
+            if (publisher)
+                publisher->publish(analyzer.facts(), PublishedFacts::RUNNING);
+        }
+        if (isStopped && !analyzer.isComplete()) {
+            state = PublishedFacts::STOPPED;
+        } else {
+            analyzer.finish();
+            if (analyzer.isComplete()) {
+                state = PublishedFacts::COMPLETE;
+            } else {
+                std::cerr << "srcFacts: Incomplete srcML in " << path << '\n';
+                status = 1;
+            }
+        }
+    } catch (const ParseError& error) {
+        std::cerr << error.what() << '\n';
+        status = 1;
+    }
+    snapshot(analyzer.facts());
+    if (publisher)
+        publisher->publish(analyzer.facts(), state);
+    close(watch);
+    close(fd);
+    return status;
+}
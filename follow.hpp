@@ -0,0 +1,24 @@
+/*
+    follow.hpp
+
+    Follow mode for srcFacts, for a srcML file that is still being written.
+*/
+
+#ifndef INCLUDED_FOLLOW_HPP
+#define INCLUDED_FOLLOW_HPP
+
+class FactsPublisher;
+
+/*
+    Analyze a srcML file as it grows, waiting with inotify for appended data,
+    with a snapshot of the facts at each interval. Ends at the end of the
+    document, when the file is deleted or moved, or on SIGINT or SIGTERM.
+
+    @param[in] path Path of the srcML file
+    @param[in] interval Seconds between snapshots
+    @param[in] publisher Publisher of the facts after each read, or nullptr
+    @return 0 on success, 1 on error
+*/
+int follow(const char* path, int interval, FactsPublisher* publisher);
+
+#endif
@@ -0,0 +1,364 @@
+/*
+    identifierIndex.cpp
+
+    On-disk inverted index from each identifier, the text of a name, to the
+    units and lines where it is used.
+*/
+
+#include "identifierIndex.hpp"
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <tuple>
+#include <memory>
+#include <cstdio>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    const char INDEX_MAGIC[] = "SFIX";
+    const uint32_t DIRECTORY_INTERVAL = 64;
+
+    void writeUInt32(std::ostream& out, uint32_t n) {
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+
+    void writeUInt64(std::ostream& out, uint64_t n) {
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    }
+
+    void writeString(std::ostream& out, std::string_view s) {
+        writeUInt32(out, static_cast<uint32_t>(s.size()));
+        out.write(s.data(), s.size());
+    }
+
+    bool readUInt32(std::istream& in, uint32_t& n) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&n), sizeof(n)));
+    }
+
+    bool readUInt64(std::istream& in, uint64_t& n) {
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(&n), sizeof(n)));
+    }
+
+    /*
+        Read a string of at most a maximum size, e.g., the size of the file,
+        so an invalid length is an error instead of a huge allocation
+
+        @param[in] in Input stream
+        @param[out] s String
+        @param[in] maxSize Maximum size of the string
+        @return Whether the string was read
+    */
+    bool readString(std::istream& in, std::string& s, uint64_t maxSize = UINT32_MAX) {
+        uint32_t size = 0;
+        if (!readUInt32(in, size) || size > maxSize)
+            return false;
+        s.resize(size);
+        return static_cast<bool>(in.read(s.data(), size));
+    }
+
+    // postings of an identifier kept in memory before they are streamed to the index
+    const std::size_t USES_BUFFER = 64 * 1024;
+
+    /*
+        Sorted run of postings in a temporary file, read one at a time
+    */
+    struct Run {
+        std::ifstream in;
+        std::string identifier;
+        uint32_t unit = 0;
+        uint32_t line = 0;
+
+        // read the next posting, false at the end of the run
+        bool next() {
+            return readString(in, identifier) && readUInt32(in, unit) && readUInt32(in, line);
+        }
+    };
+}
+
+/*
+    @param[in] path Path of the index
+    @param[in] blockPostings Maximum number of postings in memory
+*/
+IdentifierIndexWriter::IdentifierIndexWriter(std::string path, std::size_t blockPostings)
+    : path(std::move(path)), blockPostings(blockPostings) {
+    postings.reserve(std::min<std::size_t>(blockPostings, 1024 * 1024));
+}
+
+/*
+    Update the index with the next parse event
+
+    @param[in] event Parse event
+*/
+void IdentifierIndexWriter::event(const ParseEvent& event) {
+    switch (event.type) {
+    case ParseEvent::START_TAG:
+        inName = false;
+        inUnitTag = false;
+        if (!event.prefix.empty())
+            break;
+        if (event.name == "unit"sv) {
+            // each unit, including the root of an archive, gets the next unit id
+            filenames.emplace_back();
+            line = 1;
+            inUnitTag = true;
+        } else if (event.name == "name"sv) {
+            // identifiers are the innermost names
+            inName = true;
+            nameLine = line;
+            nameText.clear();
+        }
+        break;
+    case ParseEvent::ATTRIBUTE:
+        if (inUnitTag && event.prefix.empty() && event.name == "filename"sv)
+            filenames.back() = event.value;
+        break;
+    case ParseEvent::CHARACTERS:
+    case ParseEvent::CDATA:
+        if (inName)
+            nameText.append(event.value);
+        line += static_cast<uint32_t>(std::count(event.value.cbegin(), event.value.cend(), '\n'));
+        break;
+    case ParseEvent::END_TAG:
+        if (inName && !nameText.empty() && !filenames.empty()) {
+            postings.push_back({ arena.intern(nameText), static_cast<uint32_t>(filenames.size() - 1), nameLine });
+            if (postings.size() >= blockPostings)
+                writeRun();
+        }
+        inName = false;
+        inUnitTag = false;
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+    Sort the postings in memory and write them as a run file
+*/
+void IdentifierIndexWriter::writeRun() {
+    std::sort(postings.begin(), postings.end(), [](const Posting& a, const Posting& b) {
+        return std::tie(a.identifier, a.unit, a.line) < std::tie(b.identifier, b.unit, b.line);
+    });
+    runPaths.push_back(path + ".run" + std::to_string(runPaths.size()));
+    std::ofstream out(runPaths.back(), std::ios::binary);
+    for (const Posting& posting : postings) {
+        writeString(out, posting.identifier);
+        writeUInt32(out, posting.unit);
+        writeUInt32(out, posting.line);
+    }
+    if (!out)
+        isFailed = true;
+    postings.clear();
+    arena.reset();
+}
+
+/*
+    Merge the sorted blocks into the index
+
+    @return Whether the index was written
+*/
+bool IdentifierIndexWriter::finish() {
+    if (!postings.empty() || runPaths.empty())
+        writeRun();
+
+    // multiway merge of the runs, in order of identifier, unit, and line
+    std::vector<std::unique_ptr<Run>> runs;
+    for (const std::string& runPath : runPaths) {
+        runs.push_back(std::make_unique<Run>());
+        runs.back()->in.open(runPath, std::ios::binary);
+        if (!runs.back()->in)
+            isFailed = true;
+    }
+    const auto greater = [](const Run* a, const Run* b) {
+        return std::tie(a->identifier, a->unit, a->line) > std::tie(b->identifier, b->unit, b->line);
+    };
+    std::priority_queue<Run*, std::vector<Run*>, decltype(greater)> heap(greater);
+    for (const auto& run : runs) {
+        if (run->next())
+            heap.push(run.get());
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(INDEX_MAGIC, 4);
+    std::vector<std::pair<std::string, uint64_t>> directory;
+    std::string identifier;
+    uint32_t identifierCount = 0;
+
+    // postings of the current identifier, without duplicates, buffered up to a limit so that
+    // memory is bounded for frequent identifiers, e.g., i, which are streamed with their count
+    // patched at the end
+    std::vector<std::pair<uint32_t, uint32_t>> uses;
+    uses.reserve(USES_BUFFER);
+    std::pair<uint32_t, uint32_t> lastUse;
+    uint32_t useCount = 0;
+    std::streamoff countOffset = -1;
+    const auto writeUses = [&]() {
+        if (countOffset == -1) {
+            if (identifierCount % DIRECTORY_INTERVAL == 0)
+                directory.emplace_back(identifier, static_cast<uint64_t>(out.tellp()));
+            ++identifierCount;
+            writeString(out, identifier);
+            countOffset = out.tellp();
+            writeUInt32(out, useCount);
+        }
+        for (const auto& use : uses) {
+            writeUInt32(out, use.first);
+            writeUInt32(out, use.second);
+        }
+        uses.clear();
+    };
+    const auto writeIdentifier = [&]() {
+        if (useCount == 0)
+            return;
+        const bool isStreamed = countOffset != -1;
+        writeUses();
+        if (isStreamed) {
+            const std::streamoff end = out.tellp();
+            out.seekp(countOffset);
+            writeUInt32(out, useCount);
+            out.seekp(end);
+        }
+        useCount = 0;
+        countOffset = -1;
+    };
+    while (!heap.empty()) {
+        Run* run = heap.top();
+        heap.pop();
+        if (run->identifier != identifier) {
+            writeIdentifier();
+            identifier = run->identifier;
+        }
+        const std::pair<uint32_t, uint32_t> use(run->unit, run->line);
+        if (useCount == 0 || use != lastUse) {
+            if (uses.size() == USES_BUFFER)
+                writeUses();
+            uses.push_back(use);
+            lastUse = use;
+            ++useCount;
+        }
+        if (run->next())
+            heap.push(run);
+    }
+    writeIdentifier();
+
+    // filenames, after a table of their offsets
+    const uint64_t unitsOffset = static_cast<uint64_t>(out.tellp());
+    writeUInt32(out, static_cast<uint32_t>(filenames.size()));
+    uint64_t filenameOffset = unitsOffset + 4 + 8 * filenames.size();
+    for (const std::string& filename : filenames) {
+        writeUInt64(out, filenameOffset);
+        filenameOffset += 4 + filename.size();
+    }
+    for (const std::string& filename : filenames)
+        writeString(out, filename);
+
+    const uint64_t directoryOffset = static_cast<uint64_t>(out.tellp());
+    for (const auto& entry : directory) {
+        writeString(out, entry.first);
+        writeUInt64(out, entry.second);
+    }
+    writeUInt64(out, unitsOffset);
+    writeUInt64(out, directoryOffset);
+    writeUInt32(out, static_cast<uint32_t>(directory.size()));
+    out.write(INDEX_MAGIC, 4);
+    if (!out)
+        isFailed = true;
+
+    runs.clear();
+    for (const std::string& runPath : runPaths)
+        std::remove(runPath.c_str());
+    runPaths.clear();
+    return !isFailed;
+}
+
+/*
+    Write the uses of an identifier from an index as filename:line
+
+    @param[in] path Path of the index
+    @param[in] identifier Identifier to look up
+    @param[out] out Output stream
+    @return Number of uses, or -1 on an invalid index
+*/
+long lookupIdentifier(const std::string& path, std::string_view identifier, std::ostream& out) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[4] = {};
+    if (!in.read(magic, 4) || !std::equal(magic, magic + 4, INDEX_MAGIC))
+        return -1;
+
+    // lengths and counts in the index are at most its size
+    if (!in.seekg(0, std::ios::end))
+        return -1;
+    const uint64_t indexSize = static_cast<uint64_t>(in.tellg());
+
+    // footer
+    uint64_t unitsOffset = 0;
+    uint64_t directoryOffset = 0;
+    uint32_t directorySize = 0;
+    if (!in.seekg(-24, std::ios::end) || !readUInt64(in, unitsOffset) || !readUInt64(in, directoryOffset)
+        || !readUInt32(in, directorySize) || !in.read(magic, 4) || !std::equal(magic, magic + 4, INDEX_MAGIC))
+        return -1;
+
+    // last directory entry not after the identifier
+    in.seekg(directoryOffset);
+    uint64_t start = 0;
+    bool isFound = false;
+    std::string name;
+    for (uint32_t i = 0; i < directorySize; ++i) {
+        uint64_t offset = 0;
+        if (!readString(in, name, indexSize) || !readUInt64(in, offset))
+            return -1;
+        if (name > identifier)
+            break;
+        start = offset;
+        isFound = true;
+    }
+    if (!isFound)
+        return 0;
+
+    // scan the identifiers from the directory entry
+    in.seekg(start);
+    std::vector<std::pair<uint32_t, uint32_t>> uses;
+    while (static_cast<uint64_t>(in.tellg()) < unitsOffset) {
+        uint32_t count = 0;
+        if (!readString(in, name, indexSize) || !readUInt32(in, count) || static_cast<uint64_t>(count) * 8 > indexSize)
+            return -1;
+        if (name > identifier)
+            break;
+        if (name < identifier) {
+            in.seekg(static_cast<std::streamoff>(count) * 8, std::ios::cur);
+            continue;
+        }
+        uses.resize(count);
+        for (auto& use : uses) {
+            if (!readUInt32(in, use.first) || !readUInt32(in, use.second))
+                return -1;
+        }
+        break;
+    }
+    if (uses.empty())
+        return 0;
+
+    // filenames of the units used, through the offset table
+    in.seekg(unitsOffset);
+    uint32_t unitCount = 0;
+    if (!readUInt32(in, unitCount))
+        return -1;
+    std::string filename;
+    uint32_t filenameUnit = unitCount;
+    for (const auto& use : uses) {
+        if (use.first >= unitCount)
+            return -1;
+        if (use.first != filenameUnit) {
+            uint64_t offset = 0;
+            in.seekg(unitsOffset + 4 + 8 * static_cast<uint64_t>(use.first));
+            if (!readUInt64(in, offset) || !in.seekg(offset) || !readString(in, filename, indexSize))
+                return -1;
+            filenameUnit = use.first;
+        }
+        out << filename << ':' << use.second << '\n';
+    }
+    return static_cast<long>(uses.size());
+}
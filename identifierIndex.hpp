@@ -0,0 +1,91 @@
+/*
+    identifierIndex.hpp
+
+    On-disk inverted index from each identifier, the text of a name, to the
+    units and lines where it is used.
+*/
+
+#ifndef INCLUDED_IDENTIFIERINDEX_HPP
+#define INCLUDED_IDENTIFIERINDEX_HPP
+
+#include "parseEvent.hpp"
+#include "stringArena.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Builder of an identifier index from the parse events. Postings are
+    sorted in blocks of bounded size, written to temporary run files, and
+    merged into the index at the end.
+
+    Index format, in native byte order:
+    * "SFIX"
+    * identifiers in order, each a uint32 length and bytes, a uint32 posting
+      count, and the postings as uint32 unit and line
+    * uint32 unit count, uint64 offset of the filename of each unit, and the filenames
+      as uint32 length and bytes
+    * directory of every 64th identifier as uint32 length, bytes, and uint64 offset
+    * footer of uint64 offset of the units, uint64 offset and uint32 count of the directory, and "SFIX"
+*/
+class IdentifierIndexWriter {
+public:
+    /*
+        @param[in] path Path of the index
+        @param[in] blockPostings Maximum number of postings in memory
+    */
+    explicit IdentifierIndexWriter(std::string path, std::size_t blockPostings = 4 * 1024 * 1024);
+
+    /*
+        Update the index with the next parse event
+
+        @param[in] event Parse event
+    */
+    void event(const ParseEvent& event);
+
+    /*
+        Merge the sorted blocks into the index
+
+        @return Whether the index was written
+    */
+    bool finish();
+
+private:
+    struct Posting {
+        std::string_view identifier;
+        uint32_t unit;
+        uint32_t line;
+    };
+
+    void writeRun();
+
+    std::string path;
+    std::size_t blockPostings;
+    StringArena arena;
+    std::vector<Posting> postings;
+    std::vector<std::string> runPaths;
+    std::vector<std::string> filenames;
+    bool isFailed = false;
+
+    // parse state
+    bool inName = false;
+    bool inUnitTag = false;
+    uint32_t line = 1;
+    uint32_t nameLine = 1;
+    std::string nameText;
+};
+
+/*
+    Write the uses of an identifier from an index as filename:line
+
+    @param[in] path Path of the index
+    @param[in] identifier Identifier to look up
+    @param[out] out Output stream
+    @return Number of uses, or -1 on an invalid index
+*/
+long lookupIdentifier(const std::string& path, std::string_view identifier, std::ostream& out);
+
+#endif
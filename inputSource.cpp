@@ -0,0 +1,52 @@
+/*
+    inputSource.cpp
+
+    Sources of srcML input for the analyzer.
+*/
+
+#include "inputSource.hpp"
+#include <algorithm>
+#include <sys/types.h>
+#include <errno.h>
+
+#if !defined(_MSC_VER)
+#include <sys/uio.h>
+#include <unistd.h>
+#define READ ::read
+#else
+#include <BaseTsd.h>
+#include <io.h>
+typedef SSIZE_T ssize_t;
+#define READ ::_read
+#endif
+
+/*
+    Read up to size bytes from the file descriptor, retrying interrupted reads
+
+    @param[out] data Destination of the input
+    @param[in] size Maximum number of bytes to read
+    @return Number of bytes read
+    @retval 0 EOF
+    @retval -1 Read error
+*/
+int FileDescriptorSource::read(char* data, int size) {
+    ssize_t readBytes = 0;
+    while (((readBytes = READ(fd, static_cast<void*>(data), size)) == -1) && (errno == EINTR)) {
+    }
+    return static_cast<int>(readBytes);
+}
+
+/*
+    Copy up to size bytes of the remaining input
+
+    @param[out] data Destination of the input
+    @param[in] size Maximum number of bytes to read
+    @return Number of bytes read
+    @retval 0 EOF
+*/
+int StringSource::read(char* data, int size) {
+    const size_t readBytes = std::min(input.size(), static_cast<size_t>(size));
+    std::copy_n(input.data(), readBytes, data);
+    input.remove_prefix(readBytes);
+    return static_cast<int>(readBytes);
+}
@@ -0,0 +1,57 @@
+/*
+    inputSource.hpp
+
+    Sources of srcML input for the analyzer.
+*/
+
+#ifndef INCLUDED_INPUTSOURCE_HPP
+#define INCLUDED_INPUTSOURCE_HPP
+
+#include <string_view>
+
+/*
+    Source of srcML input
+*/
+class InputSource {
+public:
+    virtual ~InputSource() = default;
+
+    /*
+        Read up to size bytes of input
+
+        @param[out] data Destination of the input
+        @param[in] size Maximum number of bytes to read
+        @return Number of bytes read
+        @retval 0 EOF
+        @retval -1 Read error
+    */
+    virtual int read(char* data, int size) = 0;
+};
+
+/*
+    Input from a file descriptor, e.g., a file, pipe, or socket
+*/
+class FileDescriptorSource : public InputSource {
+public:
+    explicit FileDescriptorSource(int fd) : fd(fd) {}
+
+    int read(char* data, int size) override;
+
+private:
+    int fd;
+};
+
+/*
+    Input from memory, not owned by the source
+*/
+class StringSource : public InputSource {
+public:
+    explicit StringSource(std::string_view input) : input(input) {}
+
+    int read(char* data, int size) override;
+
+private:
+    std::string_view input;
+};
+
+#endif
@@ -0,0 +1,35 @@
+/*
+    parseEvent.hpp
+
+    Parse events of a srcML document.
+*/
+
+#ifndef INCLUDED_PARSEEVENT_HPP
+#define INCLUDED_PARSEEVENT_HPP
+
+#include <string_view>
+
+/*
+    Parse event, with views into the parser buffer. Character content,
+    comments, and CDATA may be split into more than one event. Fields that
+    an event type does not use are empty.
+*/
+struct ParseEvent {
+    enum Type : unsigned char {
+        XML_DECLARATION, START_TAG, END_TAG, NAMESPACE, ATTRIBUTE, CHARACTERS, COMMENT, CDATA, PROCESSING_INSTRUCTION
+    };
+
+    Type type = XML_DECLARATION;
+
+    // prefix of a tag, namespace, or attribute
+    std::string_view prefix{};
+
+    // local name of a tag or attribute, or target of a processing instruction
+    std::string_view name{};
+
+    // value of an attribute, uri of a namespace, content of characters, comments, and CDATA,
+    // data of a processing instruction, or version of the XML declaration
+    std::string_view value{};
+};
+
+#endif
@@ -0,0 +1,133 @@
+/*
+    perUnit.cpp
+
+    Per-unit mode for srcFacts, with the measures of each unit of an archive.
+
+    Units are analyzed in parallel on the analyzeAsync() thread pool, and
+    their results go through a bounded reorder buffer of futures, so the
+    output is in archive order. At most a window of units is in flight, so
+    memory stays bounded. A slow unit at the head only delays the output,
+    since the workers keep going on the rest of the window. On an error, the
+    rest of the window is cancelled before the input is released.
+
+    The measures are written as CSV, or with a path, to a columnar file
+    by UnitColumnsWriter.
+*/
+
+#include "perUnit.hpp"
+#include "unitScan.hpp"
+#include "unitColumns.hpp"
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <memory>
+#include <cstring>
+#include <errno.h>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+namespace {
+
+    /*
+        Value of the filename attribute of a unit start tag
+
+        @param[in] unit srcML of the unit
+        @return Filename, empty if there is none
+    */
+    std::string_view unitFilename(std::string_view unit) {
+        const std::string_view startTag = unit.substr(0, startTagEnd(unit));
+        constexpr std::string_view FILENAME = " filename=\""sv;
+        const std::size_t start = startTag.find(FILENAME);
+        if (start == std::string_view::npos)
+            return ""sv;
+        const std::string_view value = startTag.substr(start + FILENAME.size());
+        return value.substr(0, value.find('"'));
+    }
+
+    /*
+        CSV field, quoted when necessary
+
+        @param[in] field Field value
+        @return Quoted and escaped field
+    */
+    std::string csvField(std::string_view field) {
+        if (field.find_first_of(",\"\n\r") == std::string_view::npos)
+            return std::string(field);
+        std::string quoted = "\"";
+        for (const char c : field) {
+            if (c == '"')
+                quoted += '"';
+            quoted += c;
+        }
+        quoted += '"';
+        return quoted;
+    }
+}
+
+/*
+    Analyze the units of a srcML archive in parallel, and write the measures
+    of each unit as CSV, or to a columnar file, in archive order
+
+    @param[in] fd File descriptor of the srcML, mapped if it is a file
+    @param[in] columnsPath Path of the columnar file, or nullptr for CSV
+    @return 0 on success, 1 on error
+*/
+int perUnit(int fd, const char* columnsPath) {
+    InputData input(fd);
+    if (input.isError) {
+        std::cerr << "srcFacts: Unable to read input: " << strerror(errno) << '\n';
+        return 1;
+    }
+    const std::vector<std::string_view> units = findUnits(input.data);
+
+    std::unique_ptr<UnitColumnsWriter> columns;
+    if (columnsPath) {
+        columns = std::make_unique<UnitColumnsWriter>(columnsPath, units.size());
+        if (!columns->isOpen()) {
+            std::cerr << "srcFacts: Unable to create " << columnsPath << ": " << strerror(errno) << '\n';
+            return 1;
+        }
+    } else {
+        std::cout << "unit,filename,bytes,characters,loc,classes,functions,declarations,expressions,comments\n";
+    }
+
+    // reorder buffer, with the results of the units in flight in archive order
+    const std::size_t window = 4 * std::max(1u, std::thread::hardware_concurrency());
+    UnitAnalyses inFlight;
+    std::size_t submitted = 0;
+    for (std::size_t next = 0; next < units.size(); ++next) {
+        while (submitted < units.size() && submitted < next + window)
+            inFlight.submit(units[submitted++]);
+        Facts facts;
+        try {
+            facts = inFlight.next();
+        } catch (const ParseError& error) {
+            std::cerr << "srcFacts: unit " << next << ": " << error.what() << '\n';
+            return 1;
+        }
+        if (columns) {
+            if (!columns->add(facts, unitFilename(units[next]))) {
+                std::cerr << "srcFacts: Unable to write " << columnsPath << '\n';
+                return 1;
+            }
+            continue;
+        }
+        std::cout << next << ',' << csvField(unitFilename(units[next]))
+                  << ',' << facts.totalBytes
+                  << ',' << facts.textsize
+                  << ',' << facts.loc
+                  << ',' << facts.classCount
+                  << ',' << facts.functionCount
+                  << ',' << facts.declCount
+                  << ',' << facts.exprCount
+                  << ',' << facts.commentCount << '\n';
+    }
+    if (columns && !columns->finish()) {
+        std::cerr << "srcFacts: Unable to write " << columnsPath << '\n';
+        return 1;
+    }
+    return 0;
+}
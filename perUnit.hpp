@@ -0,0 +1,20 @@
+/*
+    perUnit.hpp
+
+    Per-unit mode for srcFacts, with the measures of each unit of an archive.
+*/
+
+#ifndef INCLUDED_PERUNIT_HPP
+#define INCLUDED_PERUNIT_HPP
+
+/*
+    Analyze the units of a srcML archive in parallel, and write the measures
+    of each unit as CSV, or to a columnar file, in archive order
+
+    @param[in] fd File descriptor of the srcML, mapped if it is a file
+    @param[in] columnsPath Path of the columnar file, or nullptr for CSV
+    @return 0 on success, 1 on error
+*/
+int perUnit(int fd, const char* columnsPath);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+    publish.cpp
+
+    Publication of the facts in POSIX shared memory, for local consumers
+    such as dashboards and monitors, protected by a seqlock.
+
+    The writer makes the sequence odd, writes the facts, and makes it even
+    again. A reader copies the facts between two reads of the sequence, and
+    retries if it was odd or changed. Readers never block the writer, and
+    publishing costs the writer a few stores.
+*/
+
+#include "publish.hpp"
+#include <algorithm>
+#include <thread>
+#include <new>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace {
+
+    const uint32_t PUBLISHED_MAGIC = 0x46504653;  // "SFPF"
+    const uint32_t PUBLISHED_VERSION = 1;
+}
+
+/*
+    Create the shared-memory segment, which must not exist, so two
+    publishers never share a segment
+
+    @param[in] name Name of the segment, e.g., "/srcFacts"
+*/
+FactsPublisher::FactsPublisher(const char* name) {
+    const int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1)
+        return;
+    if (ftruncate(fd, sizeof(PublishedFacts)) == 0) {
+        void* mapped = mmap(nullptr, sizeof(PublishedFacts), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapped != MAP_FAILED) {
+            published = new (mapped) PublishedFacts{};
+            published->magic = PUBLISHED_MAGIC;
+            published->version = PUBLISHED_VERSION;
+        }
+    }
+    const int error = errno;
+    close(fd);
+    if (!published) {
+        // the segment was just created, so removing it leaves nothing behind
+        shm_unlink(name);
+        errno = error;
+    }
+}
+
+FactsPublisher::~FactsPublisher() {
+    if (published)
+        munmap(published, sizeof(PublishedFacts));
+}
+
+/*
+    Publish the facts
+
+    @param[in] facts Measures so far
+    @param[in] state State of the analysis
+*/
+void FactsPublisher::publish(const Facts& facts, PublishedFacts::State state) {
+    if (!published)
+        return;
+    const uint64_t sequence = published->sequence.load(std::memory_order_relaxed);
+    published->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    published->updates.fetch_add(1, std::memory_order_relaxed);
+    published->state.store(state, std::memory_order_relaxed);
+    published->totalBytes.store(facts.totalBytes, std::memory_order_relaxed);
+    published->textsize.store(facts.textsize, std::memory_order_relaxed);
+    published->loc.store(facts.loc, std::memory_order_relaxed);
+    published->exprCount.store(facts.exprCount, std::memory_order_relaxed);
+    published->functionCount.store(facts.functionCount, std::memory_order_relaxed);
+    published->classCount.store(facts.classCount, std::memory_order_relaxed);
+    published->unitCount.store(facts.unitCount, std::memory_order_relaxed);
+    published->declCount.store(facts.declCount, std::memory_order_relaxed);
+    published->commentCount.store(facts.commentCount, std::memory_order_relaxed);
+    published->files.store(facts.files(), std::memory_order_relaxed);
+    const std::size_t urlSize = std::min(facts.url.size(), sizeof(published->url) - 1);
+    for (std::size_t i = 0; i < sizeof(published->url); ++i)
+        published->url[i].store(i < urlSize ? facts.url[i] : '\0', std::memory_order_relaxed);
+
+    published->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/*
+    Read a consistent copy of the published facts, retrying while they change,
+    up to a timeout, e.g., for a publisher that ended while writing
+
+    @param[in] published Mapped shared-memory segment
+    @param[out] snapshot Copy of the facts
+    @param[in] timeout Time to retry
+    @return Whether the segment is valid, and a consistent copy was read before the timeout
+*/
+bool readPublishedFacts(const PublishedFacts& published, PublishedSnapshot& snapshot, std::chrono::milliseconds timeout) {
+    if (published.magic != PUBLISHED_MAGIC || published.version != PUBLISHED_VERSION)
+        return false;
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (bool isRetry = false; ; isRetry = true) {
+        if (isRetry && std::chrono::steady_clock::now() >= deadline)
+            return false;
+        const uint64_t before = published.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        snapshot.updates = published.updates.load(std::memory_order_relaxed);
+        snapshot.state = static_cast<PublishedFacts::State>(published.state.load(std::memory_order_relaxed));
+        snapshot.facts.totalBytes = published.totalBytes.load(std::memory_order_relaxed);
+        snapshot.facts.textsize = static_cast<int>(published.textsize.load(std::memory_order_relaxed));
+        snapshot.facts.loc = static_cast<int>(published.loc.load(std::memory_order_relaxed));
+        snapshot.facts.exprCount = static_cast<int>(published.exprCount.load(std::memory_order_relaxed));
+        snapshot.facts.functionCount = static_cast<int>(published.functionCount.load(std::memory_order_relaxed));
+        snapshot.facts.classCount = static_cast<int>(published.classCount.load(std::memory_order_relaxed));
+        snapshot.facts.unitCount = static_cast<int>(published.unitCount.load(std::memory_order_relaxed));
+        snapshot.facts.declCount = static_cast<int>(published.declCount.load(std::memory_order_relaxed));
+        snapshot.facts.commentCount = static_cast<int>(published.commentCount.load(std::memory_order_relaxed));
+        snapshot.facts.isArchive = published.files.load(std::memory_order_relaxed) != snapshot.facts.unitCount;
+        snapshot.facts.url.clear();
+        for (const auto& c : published.url) {
+            const char value = c.load(std::memory_order_relaxed);
+            if (value == '\0')
+                break;
+            snapshot.facts.url += value;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (published.sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+}
@@ -0,0 +1,107 @@
+/*
+    publish.hpp
+
+    Publication of the facts in POSIX shared memory, for local consumers
+    such as dashboards and monitors, protected by a seqlock.
+*/
+
+#ifndef INCLUDED_PUBLISH_HPP
+#define INCLUDED_PUBLISH_HPP
+
+#include "analyze.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+    Layout of the shared-memory segment. Written by a single publisher, and
+    read with readPublishedFacts(). All fields are atomic, so a reader racing
+    the writer sees torn values at worst, and then retries.
+*/
+struct PublishedFacts {
+    // STOPPED is an analysis ended by a signal before the end of the document
+    enum State : uint32_t { RUNNING = 0, COMPLETE = 1, FAILED = 2, STOPPED = 3 };
+
+    // "SFPF"
+    uint32_t magic;
+    uint32_t version;
+
+    // seqlock sequence, odd while the facts are being written
+    std::atomic<uint64_t> sequence;
+
+    // number of publications
+    std::atomic<uint64_t> updates;
+
+    std::atomic<uint32_t> state;
+    std::atomic<int64_t> totalBytes;
+    std::atomic<int64_t> textsize;
+    std::atomic<int64_t> loc;
+    std::atomic<int64_t> exprCount;
+    std::atomic<int64_t> functionCount;
+    std::atomic<int64_t> classCount;
+    std::atomic<int64_t> unitCount;
+    std::atomic<int64_t> declCount;
+    std::atomic<int64_t> commentCount;
+    std::atomic<int64_t> files;
+    std::atomic<char> url[256];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory requires lock-free atomics");
+
+/*
+    Consistent copy of the published facts
+*/
+struct PublishedSnapshot {
+    uint64_t updates = 0;
+    PublishedFacts::State state = PublishedFacts::RUNNING;
+    Facts facts;
+};
+
+/*
+    Publisher of the facts to a POSIX shared-memory segment. The segment is
+    kept after the publisher ends, so consumers can read the final facts,
+    and must be removed, e.g., with shm_unlink(), before it is published again.
+*/
+class FactsPublisher {
+public:
+    /*
+        Create the shared-memory segment, which must not exist, so two
+        publishers never share a segment
+
+        @param[in] name Name of the segment, e.g., "/srcFacts"
+    */
+    explicit FactsPublisher(const char* name);
+    ~FactsPublisher();
+    FactsPublisher(const FactsPublisher&) = delete;
+    FactsPublisher& operator=(const FactsPublisher&) = delete;
+
+    // whether the segment was created, with errno set if not, e.g., EEXIST
+    bool isOpen() const {
+        return published != nullptr;
+    }
+
+    /*
+        Publish the facts
+
+        @param[in] facts Measures so far
+        @param[in] state State of the analysis
+    */
+    void publish(const Facts& facts, PublishedFacts::State state);
+
+private:
+    PublishedFacts* published = nullptr;
+};
+
+/*
+    Read a consistent copy of the published facts, retrying while they change,
+    up to a timeout, e.g., for a publisher that ended while writing
+
+    @param[in] published Mapped shared-memory segment
+    @param[out] snapshot Copy of the facts
+    @param[in] timeout Time to retry
+    @return Whether the segment is valid, and a consistent copy was read before the timeout
+*/
+bool readPublishedFacts(const PublishedFacts& published, PublishedSnapshot& snapshot,
+    std::chrono::milliseconds timeout = std::chrono::milliseconds(100));
+
+#endif
@@ -0,0 +1,51 @@
+/*
+    refillBuffer.cpp
+
+    Refill of the parsing buffer from an input source.
+*/
+
+#include "refillBuffer.hpp"
+#include <algorithm>
+#include <iterator>
+
+/*
+    Refill the buffer preserving the unused data.
+    Current content [cursor, cursorEnd) is shifted left and new data
+    appended to the rest of the buffer, except for the last BUFFER_PADDING
+    bytes. The BUFFER_PADDING bytes after the new data are zeroed.
+
+    @param[in] input Source of input
+    @param[in,out] cursor Iterator to current position in buffer
+    @param[in, out] cursorEnd Iterator to end of buffer for this read
+    @param[in, out] buffer Container for characters
+    @return Number of bytes read
+    @retval 0 EOF
+    @retval -1 Read error
+*/
+int refillBuffer(InputSource& input, std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer) {
+
+    // number of unprocessed characters [cursor, cursorEnd)
+    size_t unprocessed = std::distance(cursor, cursorEnd);
+
+    // move unprocessed characters, [cursor, cursorEnd), to start of the buffer
+    std::copy(cursor, cursorEnd, buffer.begin());
+
+    // reset cursors
+    cursor = buffer.begin();
+    cursorEnd = cursor + unprocessed;
+
+    // read in whole blocks
+    const int readBytes = input.read(buffer.data() + unprocessed,
+        static_cast<int>(std::distance(cursorEnd, buffer.cend()) - BUFFER_PADDING));
+    if (readBytes == -1)
+        // error in read
+        return -1;
+
+    // adjust the end of the cursor to the new bytes
+    cursorEnd += readBytes;
+
+    // lookahead past the data finds zeros, not old data
+    std::fill_n(std::next(buffer.begin(), std::distance(buffer.cbegin(), cursorEnd)), BUFFER_PADDING, '\0');
+
+    return readBytes;
+}
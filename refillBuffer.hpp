@@ -0,0 +1,32 @@
+/*
+    refillBuffer.hpp
+
+    Refill of the parsing buffer from an input source.
+*/
+
+#ifndef INCLUDED_REFILLBUFFER_HPP
+#define INCLUDED_REFILLBUFFER_HPP
+
+#include "inputSource.hpp"
+#include <string>
+
+// bytes at the end of the buffer that are never filled, so the parser can look ahead past the data
+const int BUFFER_PADDING = 64;
+
+/*
+    Refill the buffer preserving the unused data.
+    Current content [cursor, cursorEnd) is shifted left and new data
+    appended to the rest of the buffer, except for the last BUFFER_PADDING
+    bytes. The BUFFER_PADDING bytes after the new data are zeroed.
+
+    @param[in] input Source of input
+    @param[in,out] cursor Iterator to current position in buffer
+    @param[in, out] cursorEnd Iterator to end of buffer for this read
+    @param[in, out] buffer Container for characters
+    @return Number of bytes read
+    @retval 0 EOF
+    @retval -1 Read error
+*/
+int refillBuffer(InputSource& input, std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer);
+
+#endif
@@ -0,0 +1,107 @@
+/*
+    sample.cpp
+
+    Sampling mode for srcFacts, with approximate measures of large archives.
+
+    A quick scan splits the archive into units, without parsing. A random
+    sample of the units is analyzed in parallel, and each total is
+    extrapolated from the sample mean, with a confidence interval from the
+    sample variance and the finite population correction. The text of the
+    root unit between the units is analyzed and added exactly.
+*/
+
+#include "sample.hpp"
+#include "unitScan.hpp"
+#include <iostream>
+#include <iomanip>
+#include <locale>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstring>
+#include <errno.h>
+
+namespace {
+
+    // measures of a unit used in the estimates
+    using Measure = std::function<double(const Facts&)>;
+}
+
+/*
+    Estimate the measures of a srcML archive from a random sample of its
+    units, with 95% confidence intervals
+
+    @param[in] fd File descriptor of the srcML, mapped if it is a file
+    @param[in] fraction Fraction of the units to analyze, from 0 to 1
+    @param[in] seed Seed of the random sample
+    @return 0 on success, 1 on error
+*/
+int sample(int fd, double fraction, unsigned seed) {
+    InputData input(fd);
+    if (input.isError) {
+        std::cerr << "srcFacts: Unable to read input: " << strerror(errno) << '\n';
+        return 1;
+    }
+    const std::vector<std::string_view> units = findUnits(input.data);
+
+    // simple random sample of the units, without replacement
+    const std::size_t unitCount = units.size();
+    const std::size_t sampleSize = std::clamp<std::size_t>(static_cast<std::size_t>(std::ceil(fraction * unitCount)), 1, unitCount);
+    std::vector<std::string_view> sampled;
+    sampled.reserve(sampleSize);
+    std::sample(units.begin(), units.end(), std::back_inserter(sampled), sampleSize, std::mt19937(seed));
+
+    // on an error, the rest of the analyses are cancelled before the input is released
+    UnitAnalyses results;
+    for (const std::string_view unit : sampled)
+        results.submit(unit);
+    std::vector<Facts> facts;
+    facts.reserve(sampleSize);
+    Facts outside;
+    try {
+        while (results.size() > 0)
+            facts.push_back(results.next());
+        // the text between the units, e.g., newlines, is in the root unit, and counted exactly
+        outside = analyze(outsideUnits(input.data, units));
+    } catch (const ParseError& error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+
+    const std::pair<const char*, Measure> measures[] = {
+        { "Characters  ", [](const Facts& f) { return f.textsize; } },
+        { "LOC         ", [](const Facts& f) { return f.loc; } },
+        { "Classes     ", [](const Facts& f) { return f.classCount; } },
+        { "Functions   ", [](const Facts& f) { return f.functionCount; } },
+        { "Declarations", [](const Facts& f) { return f.declCount; } },
+        { "Expressions ", [](const Facts& f) { return f.exprCount; } },
+        { "Comments    ", [](const Facts& f) { return f.commentCount; } },
+    };
+    const double n = static_cast<double>(sampleSize);
+    const double populationSize = static_cast<double>(unitCount);
+    // finite population correction, 0 when every unit is in the sample
+    const double correction = unitCount > 1 ? std::sqrt((populationSize - n) / (populationSize - 1)) : 0;
+    const int valueWidth = std::max(8, static_cast<int>(std::log10(std::max<std::size_t>(input.data.size(), 1)) * 1.3 + 1));
+    std::cout.imbue(std::locale{""});
+    std::cout << "# srcFacts: sample of " << sampleSize << " of " << unitCount << " units\n";
+    std::cout << "| Measure      | " << std::setw(valueWidth + 2) << "Estimate |" << ' ' << std::setw(valueWidth + 3) << "95% CI |\n";
+    std::cout << "|:-------------|-" << std::setw(valueWidth + 2) << std::setfill('-') << ":|" << '-' << std::setw(valueWidth + 3) << ":|\n" << std::setfill(' ');
+    std::cout << "| srcML bytes  | " << std::setw(valueWidth) << input.data.size() << " | " << std::setw(valueWidth) << 0 << " |\n";
+    std::cout << "| Files        | " << std::setw(valueWidth) << unitCount << " | " << std::setw(valueWidth) << 0 << " |\n";
+    for (const auto& measure : measures) {
+        double sum = 0;
+        for (const Facts& unit : facts)
+            sum += measure.second(unit);
+        const double mean = sum / n;
+        double squares = 0;
+        for (const Facts& unit : facts)
+            squares += (measure.second(unit) - mean) * (measure.second(unit) - mean);
+        const double variance = sampleSize > 1 ? squares / (n - 1) : 0;
+        const double halfWidth = 1.96 * populationSize * std::sqrt(variance / n) * correction;
+        std::cout << "| " << measure.first << " | " << std::setw(valueWidth) << std::llround(mean * populationSize + measure.second(outside))
+                  << " | " << std::setw(valueWidth) << std::llround(halfWidth) << " |\n";
+    }
+    return 0;
+}
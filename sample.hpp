@@ -0,0 +1,21 @@
+/*
+    sample.hpp
+
+    Sampling mode for srcFacts, with approximate measures of large archives.
+*/
+
+#ifndef INCLUDED_SAMPLE_HPP
+#define INCLUDED_SAMPLE_HPP
+
+/*
+    Estimate the measures of a srcML archive from a random sample of its
+    units, with 95% confidence intervals
+
+    @param[in] fd File descriptor of the srcML, mapped if it is a file
+    @param[in] fraction Fraction of the units to analyze, from 0 to 1
+    @param[in] seed Seed of the random sample
+    @return 0 on success, 1 on error
+*/
+int sample(int fd, double fraction, unsigned seed);
+
+#endif
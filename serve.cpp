@@ -0,0 +1,328 @@
+/*
+    serve.cpp
+
+    Daemon mode for srcFacts over a Unix domain socket.
+
+    Avoids the per-run cost of process startup and buffer setup for many
+    small inputs. Connections are queued to a pool of worker threads, and
+    each worker keeps its own analyzer, with its buffer, warm across requests.
+*/
+
+#include "serve.hpp"
+#include "analyze.hpp"
+#include "publish.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+
+    // seconds a client may be idle before its request fails, so idle clients do not hold workers
+    const int CLIENT_TIMEOUT_SECONDS = 30;
+
+    // connections waiting for a worker
+    std::deque<int> pendingClients;
+    std::mutex pendingMutex;
+    std::condition_variable pendingReady;
+
+    // whether the workers end once the pending connections are answered
+    bool isStopping = false;
+
+    // publisher of the facts of each request, with a single writer at a time
+    FactsPublisher* factsPublisher = nullptr;
+    std::mutex publisherMutex;
+
+    /*
+        JSON string literal with the necessary escapes
+
+        @param[in] s String
+        @return Quoted and escaped JSON string
+    */
+    std::string jsonString(std::string_view s) {
+        std::string json = "\"";
+        for (const char c : s) {
+            if (c == '"' || c == '\\') {
+                json += '\\';
+                json += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escape[7];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                json += escape;
+            } else {
+                json += c;
+            }
+        }
+        json += '"';
+        return json;
+    }
+
+    /*
+        Facts as a single line of JSON
+
+        @param[in] facts Measures of the srcML
+        @return JSON object
+    */
+    std::string factsJSON(const Facts& facts) {
+        std::ostringstream json;
+        json << "{\"url\":" << jsonString(facts.url)
+             << ",\"bytes\":" << facts.totalBytes
+             << ",\"characters\":" << facts.textsize
+             << ",\"files\":" << facts.files()
+             << ",\"loc\":" << facts.loc
+             << ",\"classes\":" << facts.classCount
+             << ",\"functions\":" << facts.functionCount
+             << ",\"declarations\":" << facts.declCount
+             << ",\"expressions\":" << facts.exprCount
+             << ",\"comments\":" << facts.commentCount
+             << "}\n";
+        return json.str();
+    }
+
+    /*
+        Write all of the data, retrying partial and interrupted writes
+
+        @param[in] fd File descriptor
+        @param[in] data Data to write
+        @return Whether all data was written
+    */
+    bool writeAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t written = write(fd, data.data(), data.size());
+            if (written == -1 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            data.remove_prefix(written);
+        }
+        return true;
+    }
+
+    /*
+        Analyze all of the srcML from a file descriptor
+
+        @param[in] fd File descriptor of the srcML
+        @param[in,out] analyzer Analyzer, reset for a new document
+        @return Parser error message, empty on success
+    */
+    std::string analyzeInput(int fd, Analyzer& analyzer) {
+        FileDescriptorSource input(fd);
+        try {
+            while (analyzer.read(input) > 0) {
+            }
+            analyzer.finish();
+        } catch (const ParseError& error) {
+            return error.what();
+        }
+        return "";
+    }
+
+    /*
+        Answer a single request on a client connection
+
+        @param[in] client Connected client socket
+        @param[in,out] analyzer Analyzer of the worker
+    */
+    void handleClient(int client, Analyzer& analyzer) {
+
+        // peek at the first byte to tell srcML from a file path
+        char first = 0;
+        ssize_t peeked = 0;
+        while ((peeked = recv(client, &first, 1, MSG_PEEK)) == -1 && errno == EINTR) {
+        }
+        if (peeked <= 0)
+            return;
+
+        std::string error;
+        analyzer.reset();
+        if (first == '<') {
+            error = analyzeInput(client, analyzer);
+        } else {
+            // path of a srcML file up to the newline or end of the request
+            std::string path;
+            char c = 0;
+            ssize_t readBytes = 0;
+            while ((readBytes = read(client, &c, 1)) == 1 || (readBytes == -1 && errno == EINTR)) {
+                if (readBytes == 1 && c == '\n')
+                    break;
+                if (readBytes == 1)
+                    path += c;
+            }
+            if (!path.empty() && path.back() == '\r')
+                path.pop_back();
+            int fd = -1;
+            while ((fd = open(path.c_str(), O_RDONLY)) == -1 && errno == EINTR) {
+            }
+            if (fd == -1) {
+                error = "srcFacts: Unable to open " + path + ": " + strerror(errno);
+            } else {
+                error = analyzeInput(fd, analyzer);
+                close(fd);
+            }
+        }
+
+        if (factsPublisher) {
+            std::lock_guard<std::mutex> lock(publisherMutex);
+            factsPublisher->publish(analyzer.facts(), error.empty() ? PublishedFacts::COMPLETE : PublishedFacts::FAILED);
+        }
+        if (error.empty())
+            writeAll(client, factsJSON(analyzer.facts()));
+        else
+            writeAll(client, "{\"error\":" + jsonString(error) + "}\n");
+    }
+
+    /*
+        Whether a server answers on a socket
+
+        @param[in] address Address of the socket
+        @return Whether a connection was accepted
+    */
+    bool isListening(const sockaddr_un& address) {
+        const int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (probe == -1)
+            return false;
+        int result = -1;
+        while ((result = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address))) == -1 && errno == EINTR) {
+        }
+        close(probe);
+        return result == 0;
+    }
+
+    /*
+        Worker thread: answer queued connections with a warm analyzer, until stopped
+    */
+    void worker() {
+        Analyzer analyzer;
+        while (true) {
+            int client = -1;
+            {
+                std::unique_lock<std::mutex> lock(pendingMutex);
+                pendingReady.wait(lock, [] { return !pendingClients.empty() || isStopping; });
+                if (pendingClients.empty())
+                    return;
+                client = pendingClients.front();
+                pendingClients.pop_front();
+            }
+            handleClient(client, analyzer);
+            close(client);
+        }
+    }
+}
+
+/*
+    Serve srcFacts requests on a Unix domain socket until killed.
+    Each connection is one request, either:
+    * srcML, starting with '<', sent until the client shuts down writing
+    * the path of a srcML file, terminated by a newline
+    The response is the facts as a single line of JSON, or {"error": "..."}
+    A request fails if the client is idle for longer than the timeout.
+
+    @param[in] socketPath Path of the Unix domain socket, replacing a socket no server answers on
+    @param[in] threads Number of worker threads, 0 for the hardware concurrency
+    @param[in] publisher Publisher of the facts of each request, or nullptr
+    @return 1 on an error with the socket, once the accepted connections are answered
+*/
+int serve(const char* socketPath, int threads, FactsPublisher* publisher) {
+    factsPublisher = publisher;
+
+    // a client that disconnects early is an error on write, not a signal
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        std::cerr << "srcFacts: Socket path too long: " << socketPath << '\n';
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server == -1) {
+        std::cerr << "srcFacts: Unable to create socket: " << strerror(errno) << '\n';
+        return 1;
+    }
+    // replace a stale socket, but never another kind of file, or the socket of a running server
+    struct stat status;
+    if (lstat(socketPath, &status) == 0) {
+        if (!S_ISSOCK(status.st_mode)) {
+            std::cerr << "srcFacts: Not a socket: " << socketPath << '\n';
+            close(server);
+            return 1;
+        }
+        if (isListening(address)) {
+            std::cerr << "srcFacts: A server is already running on " << socketPath << '\n';
+            close(server);
+            return 1;
+        }
+        unlink(socketPath);
+    }
+
+    // path requests open files as the user of the daemon, so only that user may connect
+    const mode_t mask = umask(0077);
+    const int bound = bind(server, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+    umask(mask);
+    if (bound == -1 || chmod(socketPath, S_IRUSR | S_IWUSR) == -1) {
+        std::cerr << "srcFacts: Unable to bind " << socketPath << ": " << strerror(errno) << '\n';
+        close(server);
+        return 1;
+    }
+    if (listen(server, SOMAXCONN) == -1) {
+        std::cerr << "srcFacts: Unable to listen on " << socketPath << ": " << strerror(errno) << '\n';
+        close(server);
+        return 1;
+    }
+
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i)
+        workers.emplace_back(worker);
+    std::clog << "srcFacts: Serving on " << socketPath << " with " << threads << " threads\n";
+
+    while (true) {
+        const int client = accept(server, nullptr, nullptr);
+        if (client == -1) {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            std::cerr << "srcFacts: Unable to accept on " << socketPath << ": " << strerror(errno) << '\n';
+            break;
+        }
+        timeval timeout{};
+        timeout.tv_sec = CLIENT_TIMEOUT_SECONDS;
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        {
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pendingClients.push_back(client);
+        }
+        pendingReady.notify_one();
+    }
+
+    // answer the connections already accepted, then end the workers
+    close(server);
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        isStopping = true;
+    }
+    pendingReady.notify_all();
+    for (auto& thread : workers)
+        thread.join();
+    return 1;
+}
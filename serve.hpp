@@ -0,0 +1,27 @@
+/*
+    serve.hpp
+
+    Daemon mode for srcFacts over a Unix domain socket.
+*/
+
+#ifndef INCLUDED_SERVE_HPP
+#define INCLUDED_SERVE_HPP
+
+class FactsPublisher;
+
+/*
+    Serve srcFacts requests on a Unix domain socket until killed.
+    Each connection is one request, either:
+    * srcML, starting with '<', sent until the client shuts down writing
+    * the path of a srcML file, terminated by a newline
+    The response is the facts as a single line of JSON, or {"error": "..."}
+    A request fails if the client is idle for longer than the timeout.
+
+    @param[in] socketPath Path of the Unix domain socket, replacing a socket no server answers on
+    @param[in] threads Number of worker threads, 0 for the hardware concurrency
+    @param[in] publisher Publisher of the facts of each request, or nullptr
+    @return 1 on an error with the socket, once the accepted connections are answered
+*/
+int serve(const char* socketPath, int threads, FactsPublisher* publisher);
+
+#endif
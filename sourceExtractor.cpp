@@ -0,0 +1,92 @@
+/*
+    sourceExtractor.cpp
+
+    Source code text of the units of srcML, i.e., srcML without the markup.
+*/
+
+#include "sourceExtractor.hpp"
+#include "writeSlices.hpp"
+#include <limits.h>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*
+    @param[in] fd File descriptor for the source code
+*/
+SourceExtractor::SourceExtractor(int fd)
+    : fd(fd) {
+    slices.reserve(IOV_MAX);
+}
+
+/*
+    Add the source of the next parse event
+
+    @param[in] event Parse event
+    @return Whether all output so far was written
+*/
+bool SourceExtractor::event(const ParseEvent& event) {
+    switch (event.type) {
+    case ParseEvent::START_TAG:
+        ++depth;
+        if (depth == 2 && isArchive == -1) {
+            // an archive is a root unit of units, with only whitespace between them
+            isArchive = event.prefix.empty() && event.name == "unit"sv;
+            if (!isArchive)
+                add(rootText);
+        }
+        break;
+    case ParseEvent::END_TAG:
+        --depth;
+        if (depth == 1 && isArchive == 1) {
+            // end of a unit of an archive, with a separator that XML text cannot contain
+            add("\0"sv);
+        } else if (depth == 0 && isArchive == -1) {
+            // a root unit with no elements is a single source file
+            isArchive = 0;
+            add(rootText);
+        }
+        break;
+    case ParseEvent::CHARACTERS:
+    case ParseEvent::CDATA:
+        if (depth >= 2) {
+            add(event.value);
+        } else if (depth == 1) {
+            // text of the root unit before its first element is kept until it is known to be source
+            if (isArchive == -1)
+                rootText.append(event.value);
+            else if (!isArchive)
+                add(event.value);
+        }
+        break;
+    default:
+        break;
+    }
+    if (slices.size() == IOV_MAX)
+        return flush();
+    return true;
+}
+
+/*
+    Add a slice of source to the output
+
+    @param[in] text Source text, valid until the next flush
+*/
+void SourceExtractor::add(std::string_view text) {
+    if (text.empty())
+        return;
+    slices.push_back({ const_cast<char*>(text.data()), text.size() });
+}
+
+/*
+    Write the pending source, before the views of the events are invalid
+
+    @return Whether all output was written
+*/
+bool SourceExtractor::flush() {
+    return writeSlices(fd, slices);
+}
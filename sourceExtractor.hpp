@@ -0,0 +1,54 @@
+/*
+    sourceExtractor.hpp
+
+    Source code text of the units of srcML, i.e., srcML without the markup.
+*/
+
+#ifndef INCLUDED_SOURCEEXTRACTOR_HPP
+#define INCLUDED_SOURCEEXTRACTOR_HPP
+
+#include "parseEvent.hpp"
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+
+/*
+    Writer of the source code of each unit from the parse events: character
+    runs, decoded entities, and CDATA. The text is written with writev()
+    directly from the views of the events, so there are no copies. In an
+    archive, the source of each unit is followed by a '\0', so the output
+    splits back into the units in archive order.
+*/
+class SourceExtractor {
+public:
+    /*
+        @param[in] fd File descriptor for the source code
+    */
+    explicit SourceExtractor(int fd);
+
+    /*
+        Add the source of the next parse event
+
+        @param[in] event Parse event
+        @return Whether all output so far was written
+    */
+    bool event(const ParseEvent& event);
+
+    /*
+        Write the pending source, before the views of the events are invalid
+
+        @return Whether all output was written
+    */
+    bool flush();
+
+private:
+    void add(std::string_view text);
+
+    int fd;
+    std::vector<iovec> slices;
+    int depth = 0;
+    int isArchive = -1;
+    std::string rootText;
+};
+
+#endif
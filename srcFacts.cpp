@@ -10,592 +10,427 @@
 
     Output performance statistics to stderr.
 
-    Code includes an embedded XML parser:
-    * No checking for well-formedness
-    * No DTD declarations
+    With --call-graph, also writes the caller to callee edges of the
+    functions as CSV, or with --call-graph-binary, in binary.
+
+    With --histogram, also writes the count of each element as CSV, and
+    with --complexity, the cyclomatic complexity of each function. All of
+    the analyses of the parse events share one pass of the parser.
+
+    With --index, also writes an inverted index of the identifiers, which
+    --lookup searches for the uses of an identifier.
+
+    With --emit-events, writes the parse events as a compact binary stream
+    instead of the report.
+
+    With --extract-source, writes the source code of the units instead of
+    the report.
+
+    With --filename or --language, writes the srcML of the matching units
+    instead of the report.
+
+    With --follow, analyzes a file as it is appended to, with a snapshot of
+    the measures at each interval.
+
+    With --sample, estimates the measures from a random sample of the
+    units, with 95% confidence intervals.
+
+    With --dedup, analyzes identical units once, and reports the totals of
+    all units and of the unique units.
+
+    With --per-unit, writes the measures of each unit as CSV, in archive
+    order, instead of the report, or with --columns, to a columnar file.
+
+    With --publish, also publishes the measures during and after the
+    analysis in POSIX shared memory, for the report, --follow, or --serve.
+
+    With --serve, runs as a daemon on a Unix domain socket, with the
+    measures of each request as JSON.
 */
 
+#include "analyze.hpp"
+#include "eventGenerator.hpp"
+#include "eventHandlers.hpp"
+#include "callGraph.hpp"
+#include "elementHistogram.hpp"
+#include "complexity.hpp"
+#include "identifierIndex.hpp"
+#include "eventStream.hpp"
+#if !defined(_MSC_VER)
+#include "sourceExtractor.hpp"
+#include "unitFilter.hpp"
+#endif
+#include <memory>
 #include <iostream>
+#include <fstream>
 #include <locale>
-#include <iterator>
 #include <string>
-#include <algorithm>
-#include <cstring>
-#include <sys/types.h>
-#include <errno.h>
-#include <ctype.h>
 #include <string_view>
-#include <optional>
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
 #include <chrono>
-#include <memory>
-#include <string.h>
+#include <cstring>
 #include <stdlib.h>
-#include <bitset>
-
-#if !defined(_MSC_VER)
-#include <sys/uio.h>
-#include <unistd.h>
-#define READ read
-#else
-#include <BaseTsd.h>
+#include <errno.h>
+#if defined(_MSC_VER)
 #include <io.h>
-typedef SSIZE_T ssize_t;
-#define READ _read
+#include <fcntl.h>
 #endif
 
-// provides literal string operator""sv
-using namespace std::literals::string_view_literals;
-
-const int BUFFER_SIZE = 16 * 16 * 4096;
-
-std::bitset<128> tagNameMask("00000111111111111111111111111110100001111111111111111111111111100000001111111111011000000000000000000000000000000000000000000000");
-
-/*
-    Refill the buffer preserving the unused data.
-    Current content [cursor, cursorEnd) is shifted left and new data
-    appended to the rest of the buffer.
+#if !defined(_MSC_VER)
+#include "serve.hpp"
+#include "publish.hpp"
+#endif
 
-    @param[in,out] cursor Iterator to current position in buffer
-    @param[in, out] cursorEnd Iterator to end of buffer for this read
-    @param[in, out] buffer Container for characters
-    @return Number of bytes read
-    @retval 0 EOF
-    @retval -1 Read error
-*/
-int refillBuffer(std::string::const_iterator& cursor, std::string::const_iterator& cursorEnd, std::string& buffer) {
+#if defined(__linux__)
+#include "follow.hpp"
+#endif
 
-    // number of unprocessed characters [cursor, cursorEnd)
-    size_t unprocessed = std::distance(cursor, cursorEnd);
+#if !defined(_MSC_VER)
+#include "sample.hpp"
+#include "dedup.hpp"
+#include "perUnit.hpp"
+#include <random>
+#endif
 
-    // move unprocessed characters, [cursor, cursorEnd), to start of the buffer
-    std::copy(cursor, cursorEnd, buffer.begin());
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
 
-    // reset cursors
-    cursor = buffer.begin();
-    cursorEnd = cursor + unprocessed;
+namespace {
 
-    // read in whole blocks
-    ssize_t readBytes = 0;
-    while (((readBytes = READ(0, static_cast<void*>(buffer.data() + unprocessed),
-        std::distance(cursorEnd, buffer.cend()))) == -1) && (errno == EINTR)) {
+    // print the usage of each mode
+    void usage() {
+        std::cerr << "usage: srcFacts [--publish <shm name>] < input.xml\n"
+                  << "       srcFacts [--call-graph[-binary] <file>] [--histogram <file>] [--complexity <file>] [--index <file>]\n"
+                  << "                [--emit-events] < input.xml\n"
+                  << "       srcFacts --extract-source < input.xml\n"
+                  << "       srcFacts [--filename <glob>] [--language <language>] < input.xml\n"
+                  << "       srcFacts --sample <percent>% [--seed <n>] < input.xml\n"
+                  << "       srcFacts --dedup < input.xml\n"
+                  << "       srcFacts --per-unit [--columns <file>] < input.xml\n"
+                  << "       srcFacts --follow <file> [--interval <seconds>] [--publish <shm name>]\n"
+                  << "       srcFacts --serve <socket> [--threads <n>] [--publish <shm name>]\n"
+                  << "       srcFacts --lookup <index> <identifier>\n";
     }
-    if (readBytes == -1)
-        // error in read
-        return -1;
-    if (readBytes == 0) {
-        // EOF
-        cursor = buffer.cend();
-        cursorEnd = buffer.cend();
-        return 0;
-    }
-
-    // adjust the end of the cursor to the new bytes
-    cursorEnd += readBytes;
-
-    return readBytes;
 }
 
-// trace parsing
-#ifdef TRACE
-#undef TRACE
-#define HEADER(m) std::clog << std::setw(10) << std::left << m <<"\t"
-#define FIELD(l, n) l << ":|" << n << "| "
-#define TRACE0(m)
-#define TRACE1(m, l1, n1) HEADER(m) << FIELD(l1,n1) << '\n';
-#define TRACE2(m, l1, n1, l2, n2) HEADER(m) << FIELD(l1,n1) << FIELD(l2,n2) << '\n';
-#define TRACE3(m, l1, n1, l2, n2, l3, n3) HEADER(m) << FIELD(l1,n1) << FIELD(l2,n2) << FIELD(l3,n3) << '\n';
-#define TRACE4(m, l1, n1, l2, n2, l3, n3, l4, n4) HEADER(m) << FIELD(l1,n1) << FIELD(l2,n2) << FIELD(l3,n3) << FIELD(l4,n4) << '\n';
-#define GET_TRACE(_1,_2,_3,_4,_5,_6,_7,_8,_9,NAME,...) NAME
-#define TRACE(...) GET_TRACE(__VA_ARGS__, TRACE4, _UNUSED, TRACE3, _UNUSED, TRACE2, _UNUSED, TRACE1, _UNUSED, TRACE0)(__VA_ARGS__)
-#else
-#define TRACE(...)
-#endif
-
-int main() {
+int main(int argc, char* argv[]) {
     const auto start = std::chrono::steady_clock::now();
-    std::string url;
-    int textsize = 0;
-    int loc = 0;
-    int exprCount = 0;
-    int functionCount = 0;
-    int classCount = 0;
-    int unitCount = 0;
-    int declCount = 0;
-    int commentCount = 0;
-    int depth = 0;
-    long totalBytes = 0;
-    bool inTag = false;
-    bool inXMLComment = false;
-    bool inCDATA = false;
-    std::string inTagQName;
-    std::string_view inTagPrefix;
-    std::string_view inTagLocalName;
-    bool isArchive = false;
-    std::string buffer(BUFFER_SIZE, ' ');
-    std::string::const_iterator cursor = buffer.cend();
-    std::string::const_iterator cursorEnd = buffer.cend();
-    TRACE("START DOCUMENT");
-    while (true) {
-        if (std::distance(cursor, cursorEnd) < 5) {
-            // refill buffer and adjust iterator
-            int bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-            if (bytesRead < 0) {
-                std::cerr << "parser error : File input error\n";
-                return 1;
-            }
-            totalBytes += bytesRead;
-            if (!inXMLComment && !inCDATA && cursor == cursorEnd)
-                break;
-        } else if (inTag && (strncmp(std::addressof(*cursor), "xmlns", 5) == 0) && (cursor[5] == ':' || cursor[5] == '=')) {
-            // parse XML namespace
-            std::advance(cursor, 5);
-            const std::string::const_iterator nameEnd = std::find(cursor, cursorEnd, '=');
-            if (nameEnd == cursorEnd) {
-                std::cerr << "parser error : incomplete namespace\n";
-                return 1;
-            }
-            int prefixSize = 0;
-            if (*cursor == ':') {
-                std::advance(cursor, 1);
-                prefixSize = std::distance(cursor, nameEnd);
-            }
-            const std::string_view prefix(std::addressof(*cursor), prefixSize);
-            cursor = std::next(nameEnd);
-            cursor = std::find_if_not(cursor, cursorEnd, isspace);
-            if (cursor == cursorEnd) {
-                std::cerr << "parser error : incomplete namespace\n";
-                return 1;
-            }
-            const char delimiter = *cursor;
-            if (delimiter != '"' && delimiter != '\'') {
-                std::cerr << "parser error : incomplete namespace\n";
+    const char* socketPath = nullptr;
+    int threads = 0;
+    const char* callGraphPath = nullptr;
+    bool isCallGraphBinary = false;
+    const char* indexPath = nullptr;
+    const char* histogramPath = nullptr;
+    const char* complexityPath = nullptr;
+    bool isExtractSource = false;
+    bool isEmitEvents = false;
+    const char* filenamePattern = nullptr;
+    const char* followPath = nullptr;
+    int interval = 5;
+    bool isInterval = false;
+    double sampleFraction = 0;
+    const char* sampleSeed = nullptr;
+    bool isDedup = false;
+    bool isPerUnit = false;
+    const char* columnsPath = nullptr;
+    const char* publishName = nullptr;
+    const char* language = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        if (arg == "--serve"sv && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--threads"sv && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if ((arg == "--call-graph"sv || arg == "--call-graph-binary"sv) && i + 1 < argc) {
+            isCallGraphBinary = arg == "--call-graph-binary"sv;
+            callGraphPath = argv[++i];
+        } else if (arg == "--extract-source"sv) {
+            isExtractSource = true;
+        } else if (arg == "--emit-events"sv) {
+            isEmitEvents = true;
+        } else if (arg == "--follow"sv && i + 1 < argc) {
+            followPath = argv[++i];
+        } else if (arg == "--interval"sv && i + 1 < argc) {
+            interval = atoi(argv[++i]);
+            isInterval = true;
+        } else if (arg == "--sample"sv && i + 1 < argc) {
+            // percent, e.g., 1%, or a fraction, of at most all of the units
+            const char* value = argv[++i];
+            char* valueEnd = nullptr;
+            sampleFraction = strtod(value, &valueEnd);
+            if (valueEnd != value && *valueEnd == '%') {
+                sampleFraction /= 100;
+                ++valueEnd;
+            }
+            if (valueEnd == value || *valueEnd != '\0' || !(sampleFraction > 0 && sampleFraction <= 1)) {
+                std::cerr << "srcFacts: Invalid sample " << value << ", expected a percent in (0, 100%] or a fraction in (0, 1]\n";
                 return 1;
             }
-            std::advance(cursor, 1);
-            const std::string::const_iterator valueEnd = std::find(cursor, cursorEnd, delimiter);
-            if (valueEnd == cursorEnd) {
-                std::cerr << "parser error : incomplete namespace\n";
+        } else if (arg == "--seed"sv && i + 1 < argc) {
+            sampleSeed = argv[++i];
+        } else if (arg == "--dedup"sv) {
+            isDedup = true;
+        } else if (arg == "--per-unit"sv) {
+            isPerUnit = true;
+        } else if (arg == "--columns"sv && i + 1 < argc) {
+            columnsPath = argv[++i];
+        } else if (arg == "--publish"sv && i + 1 < argc) {
+            publishName = argv[++i];
+        } else if (arg == "--filename"sv && i + 1 < argc) {
+            filenamePattern = argv[++i];
+        } else if (arg == "--language"sv && i + 1 < argc) {
+            language = argv[++i];
+        } else if (arg == "--histogram"sv && i + 1 < argc) {
+            histogramPath = argv[++i];
+        } else if (arg == "--complexity"sv && i + 1 < argc) {
+            complexityPath = argv[++i];
+        } else if (arg == "--index"sv && i + 1 < argc) {
+            indexPath = argv[++i];
+        } else if (arg == "--lookup"sv && i + 2 < argc) {
+            const long uses = lookupIdentifier(argv[i + 1], argv[i + 2], std::cout);
+            if (uses < 0) {
+                std::cerr << "srcFacts: Invalid index " << argv[i + 1] << '\n';
                 return 1;
             }
-            const std::string_view uri(std::addressof(*cursor), std::distance(cursor, valueEnd));
-            TRACE("NAMESPACE", "prefix", prefix, "uri", uri);
-            cursor = std::next(valueEnd);
-            cursor = std::find_if_not(cursor, cursorEnd, isspace);
-            if (*cursor == '>') {
-                std::advance(cursor, 1);
-                inTag = false;
-                ++depth;
-            } else if (*cursor == '/' && cursor[1] == '>') {
-                std::advance(cursor, 2);
-                TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
-                inTag = false;
-            }
-        } else if (inTag) {
-            // parse attribute
-            const std::string::const_iterator nameEnd = std::find_if_not(cursor, cursorEnd, [] (char c) { return tagNameMask[c]; });
-            if (nameEnd == cursorEnd) {
-                std::cerr << "parser error : Empty attribute name" << '\n';
-                return 1;
-            }
-            const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
-            size_t colonPosition = qName.find(':');
-            if (colonPosition == 0) {
-                std::cerr << "parser error : Invalid attribute name " << qName << '\n';
-                return 1;
-            }
-            if (colonPosition == std::string::npos)
-                colonPosition = 0;
-            const std::string_view prefix(std::addressof(*qName.cbegin()), colonPosition);
-            if (colonPosition != 0)
-                colonPosition += 1;
-            const std::string_view localName(std::addressof(*qName.cbegin()) + colonPosition, qName.size() - colonPosition);
-            cursor = nameEnd;
-            if (isspace(*cursor))
-                cursor = std::find_if_not(cursor, cursorEnd, isspace);
-            if (cursor == cursorEnd) {
-                std::cerr << "parser error : attribute " << qName << " incomplete attribute\n";
-                return 1;
-            }
-            if (*cursor != '=') {
-                std::cerr << "parser error : attribute " << qName << " missing =\n";
-                return 1;
-            }
-            std::advance(cursor, 1);
-            if (isspace(*cursor))
-                cursor = std::find_if_not(cursor, cursorEnd, isspace);
-            const char delimiter = *cursor;
-            if (delimiter != '"' && delimiter != '\'') {
-                std::cerr << "parser error : attribute " << qName << " missing delimiter\n";
-                return 1;
-            }
-            std::advance(cursor, 1);
-            std::string::const_iterator valueEnd = std::find(cursor, cursorEnd, delimiter);
-            if (valueEnd == cursorEnd) {
-                std::cerr << "parser error : attribute " << qName << " missing delimiter\n";
-                return 1;
-            }
-            const std::string_view value(std::addressof(*cursor), std::distance(cursor, valueEnd));
-            if (localName == "url"sv)
-                url = value;
-            TRACE("ATTRIBUTE", "prefix", prefix, "qname", qName, "localName", localName, "value", value);
-            cursor = std::next(valueEnd);
-            if (isspace(*cursor))
-                cursor = std::find_if_not(std::next(cursor), cursorEnd, isspace);
-            if (*cursor == '>') {
-                std::advance(cursor, 1);
-                inTag = false;
-                ++depth;
-            } else if (*cursor == '/' && cursor[1] == '>') {
-                std::advance(cursor, 2);
-                TRACE("END TAG", "prefix", inTagPrefix, "qName", inTagQName, "localName", inTagLocalName);
-                inTag = false;
-            }
-        } else if (inXMLComment || (cursor[1] == '!' && *cursor == '<' && cursor[2] == '-' && cursor[3] == '-')) {
-            // parse XML comment
-            if (cursor == cursorEnd) {
-                std::cerr << "parser error : Unterminated XML comment\n";
-                return 1;
-            }
-            if (!inXMLComment)
-                std::advance(cursor, 4);
-            constexpr std::string_view endComment = "-->"sv;
-            std::string::const_iterator tagEnd = std::search(cursor, cursorEnd, endComment.begin(), endComment.end());
-            inXMLComment = tagEnd == cursorEnd;
-            const std::string_view comment(std::addressof(*cursor), std::distance(cursor, tagEnd));
-            TRACE("COMMENT", "comment", comment);
-            if (!inXMLComment)
-                cursor = std::next(tagEnd, endComment.size());
-            else
-                cursor = tagEnd;
-        } else if (inCDATA || (cursor[1] == '!' && *cursor == '<' && cursor[2] == '[' && (strncmp(std::addressof(cursor[3]), "CDATA[", 6) == 0))) {
-            // parse CDATA
-            if (cursor == cursorEnd) {
-                std::cerr << "parser error : Unterminated CDATA\n";
-                return 1;
-            }
-            constexpr std::string_view endCDATA = "]]>"sv;
-            if (!inCDATA)
-                std::advance(cursor, 9);
-            std::string::const_iterator tagEnd = std::search(cursor, cursorEnd, endCDATA.begin(), endCDATA.end());
-            inCDATA = tagEnd == cursorEnd;
-            const std::string_view characters(std::addressof(*cursor), std::distance(cursor, tagEnd));
-            TRACE("CDATA", "characters", characters);
-            textsize += static_cast<int>(characters.size());
-            loc += static_cast<int>(std::count(characters.begin(), characters.end(), '\n'));
-            cursor = std::next(tagEnd, endCDATA.size());
-            if (!inCDATA)
-                cursor = std::next(tagEnd, endCDATA.size());
-            else
-                cursor = tagEnd;
-        } else if (cursor[1] == '?' && *cursor == '<' && (strncmp(std::addressof(*cursor), "<?xml ", 6) == 0)) {
-            // parse XML declaration
-            constexpr std::string_view startXMLDecl = "<?xml";
-            constexpr std::string_view endXMLDecl = "?>";
-            std::string::const_iterator tagEnd = std::find(cursor, cursorEnd, '>');
-            if (tagEnd == cursorEnd) {
-                int bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-                if (bytesRead < 0) {
-                    std::cerr << "parser error : File input error\n";
-                    return 1;
-                }
-                totalBytes += bytesRead;
-                if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd) {
-                    std::cerr << "parser error: Incomplete XML declaration\n";
-                    return 1;
-                }
-            }
-            std::advance(cursor, startXMLDecl.size());
-            cursor = std::find_if_not(cursor, tagEnd, isspace);
-            // parse required version
-            if (cursor == tagEnd) {
-                std::cerr << "parser error: Missing space after before version in XML declaration\n";
-                return 1;
-            }
-            std::string::const_iterator nameEnd = std::find(cursor, tagEnd, '=');
-            const std::string_view attr(std::addressof(*cursor), std::distance(cursor, nameEnd));
-            cursor = std::next(nameEnd);
-            const char delimiter = *cursor;
-            if (delimiter != '"' && delimiter != '\'') {
-                std::cerr << "parser error: Invalid start delimiter for version in XML declaration\n";
-                return 1;
-            }
-            std::advance(cursor, 1);
-            std::string::const_iterator valueEnd = std::find(cursor, tagEnd, delimiter);
-            if (valueEnd == tagEnd) {
-                std::cerr << "parser error: Invalid end delimiter for version in XML declaration\n";
-                return 1;
-            }
-            if (attr != "version"sv) {
-                std::cerr << "parser error: Missing required first attribute version in XML declaration\n";
-                return 1;
-            }
-            const std::string_view version(std::addressof(*cursor), std::distance(cursor, valueEnd));
-            cursor = std::next(valueEnd);
-            cursor = std::find_if_not(cursor, tagEnd, isspace);
-            // parse optional encoding and standalone attributes
-            std::optional<std::string_view> encoding;
-            std::optional<std::string_view> standalone;
-            if (cursor != (tagEnd - 1)) {
-                nameEnd = std::find(cursor, tagEnd, '=');
-                if (nameEnd == tagEnd) {
-                    std::cerr << "parser error: Incomplete attribute in XML declaration\n";
-                    return 1;
-                }
-                const std::string_view attr2(std::addressof(*cursor), std::distance(cursor, nameEnd));
-                cursor = std::next(nameEnd);
-                char delimiter2 = *cursor;
-                if (delimiter2 != '"' && delimiter2 != '\'') {
-                    std::cerr << "parser error: Invalid end delimiter for attribute " << attr2 << " in XML declaration\n";
-                    return 1;
-                }
-                std::advance(cursor, 1);
-                valueEnd = std::find(cursor, tagEnd, delimiter2);
-                if (valueEnd == tagEnd) {
-                    std::cerr << "parser error: Incomplete attribute " << attr2 << " in XML declaration\n";
-                    return 1;
-                }
-                if (attr2 == "encoding"sv) {
-                    encoding = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
-                } else if (attr2 == "standalone"sv) {
-                    standalone = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
-                } else {
-                    std::cerr << "parser error: Invalid attribute " << attr2 << " in XML declaration\n";
-                    return 1;
-                }
-                cursor = std::next(valueEnd);
-                cursor = std::find_if_not(cursor, tagEnd, isspace);
-            }
-            if (cursor != (tagEnd - endXMLDecl.size() + 1)) {
-                nameEnd = std::find(cursor, tagEnd, '=');
-                if (nameEnd == tagEnd) {
-                    std::cerr << "parser error: Incomplete attribute in XML declaration\n";
-                    return 1;
-                }
-                const std::string_view attr2(std::addressof(*cursor), std::distance(cursor, nameEnd));
-                cursor = std::next(nameEnd);
-                const char delimiter2 = *cursor;
-                if (delimiter2 != '"' && delimiter2 != '\'') {
-                    std::cerr << "parser error: Invalid end delimiter for attribute " << attr2 << " in XML declaration\n";
-                    return 1;
-                }
-                std::advance(cursor, 1);
-                valueEnd = std::find(cursor, tagEnd, delimiter2);
-                if (valueEnd == tagEnd) {
-                    std::cerr << "parser error: Incomplete attribute " << attr2 << " in XML declaration\n";
-                    return 1;
-                }
-                if (!standalone && attr2 == "standalone"sv) {
-                    standalone = std::string_view(std::addressof(*cursor), std::distance(cursor, valueEnd));
-                } else {
-                    std::cerr << "parser error: Invalid attribute " << attr2 << " in XML declaration\n";
-                    return 1;
-                }
-                cursor = std::next(valueEnd);
-                cursor = std::find_if_not(cursor, tagEnd, isspace);
-            }
-            TRACE("XML DECLARATION", "version", version, "encoding", (encoding ? *encoding : ""), "standalone", (standalone ? *standalone : ""));
-            std::advance(cursor, endXMLDecl.size());
-            cursor = std::find_if_not(cursor, cursorEnd, isspace);
-        } else if (cursor[1] == '?' && *cursor == '<') {
-            // parse processing instruction
-            constexpr std::string_view endPI = "?>";
-            std::string::const_iterator tagEnd = std::search(cursor, cursorEnd, endPI.begin(), endPI.end());
-            if (tagEnd == cursorEnd) {
-                int bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-                if (bytesRead < 0) {
-                    std::cerr << "parser error : File input error\n";
-                    return 1;
-                }
-                totalBytes += bytesRead;
-                if ((tagEnd = std::search(cursor, cursorEnd, endPI.begin(), endPI.end())) == cursorEnd) {
-                    std::cerr << "parser error: Incomplete XML declaration\n";
+            return uses > 0 ? 0 : 2;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    // options that another mode would ignore are errors
+    const int modeCount = (socketPath != nullptr) + (followPath != nullptr) + isPerUnit + isDedup + (sampleFraction > 0)
+        + isExtractSource + (filenamePattern || language);
+    const bool isEventAnalysis = callGraphPath || histogramPath || complexityPath || indexPath || isEmitEvents;
+    const char* conflict = nullptr;
+    if (modeCount > 1)
+        conflict = "Choose one of --serve, --follow, --per-unit, --dedup, --sample, --extract-source, or --filename and --language";
+    else if (modeCount > 0 && isEventAnalysis)
+        conflict = "--call-graph, --histogram, --complexity, --index, and --emit-events do not work with another mode";
+    else if (publishName && (isEventAnalysis || (modeCount > 0 && !socketPath && !followPath)))
+        conflict = "--publish only works with the report, --follow, or --serve";
+    else if (columnsPath && !isPerUnit)
+        conflict = "--columns requires --per-unit";
+    else if (sampleSeed && !(sampleFraction > 0))
+        conflict = "--seed requires --sample";
+    else if (threads != 0 && !socketPath)
+        conflict = "--threads requires --serve";
+    else if (isInterval && !followPath)
+        conflict = "--interval requires --follow";
+    if (conflict) {
+        std::cerr << "srcFacts: " << conflict << '\n';
+        usage();
+        return 1;
+    }
+#if !defined(_MSC_VER)
+    std::unique_ptr<FactsPublisher> publisher;
+    if (publishName) {
+        publisher = std::make_unique<FactsPublisher>(publishName);
+        if (!publisher->isOpen()) {
+            std::cerr << "srcFacts: Unable to publish to shared memory " << publishName << ": " << strerror(errno) << '\n';
+            if (errno == EEXIST)
+                std::cerr << "srcFacts: Remove the segment if no other srcFacts publishes to it, e.g., rm /dev/shm" << publishName << '\n';
+            return 1;
+        }
+    }
+#else
+    if (publishName) {
+        std::cerr << "srcFacts: --publish is not supported on this platform\n";
+        return 1;
+    }
+#endif
+    if (socketPath) {
+#if !defined(_MSC_VER)
+        return serve(socketPath, threads, publisher.get());
+#else
+        std::cerr << "srcFacts: --serve is not supported on this platform\n";
+        return 1;
+#endif
+    }
+    if (followPath) {
+#if defined(__linux__)
+        return follow(followPath, interval, publisher.get());
+#else
+        std::cerr << "srcFacts: --follow is not supported on this platform\n";
+        return 1;
+#endif
+    }
+    if (isPerUnit) {
+#if !defined(_MSC_VER)
+        return perUnit(0, columnsPath);
+#else
+        std::cerr << "srcFacts: --per-unit is not supported on this platform\n";
+        return 1;
+#endif
+    }
+    if (isDedup) {
+#if !defined(_MSC_VER)
+        return dedup(0);
+#else
+        std::cerr << "srcFacts: --dedup is not supported on this platform\n";
+        return 1;
+#endif
+    }
+    if (sampleFraction > 0) {
+#if !defined(_MSC_VER)
+        const unsigned seed = sampleSeed ? static_cast<unsigned>(strtoul(sampleSeed, nullptr, 10)) : std::random_device()();
+        return sample(0, sampleFraction, seed);
+#else
+        std::cerr << "srcFacts: --sample is not supported on this platform\n";
+        return 1;
+#endif
+    }
+    FileDescriptorSource input(0);
+    if (isExtractSource) {
+#if !defined(_MSC_VER)
+        SourceExtractor extractor(1);
+        try {
+            EventGenerator events(input);
+            for (const ParseEvent& event : events) {
+                // the views of the events are only valid until the next refill
+                if (!extractor.event(event) || (events.available() == 0 && !extractor.flush())) {
+                    std::cerr << "srcFacts: Unable to write source\n";
                     return 1;
                 }
             }
-            std::advance(cursor, 2);
-            std::string::const_iterator nameEnd = std::find_if_not(cursor, tagEnd, [] (char c) { return tagNameMask[c]; });
-            if (nameEnd == tagEnd) {
-                std::cerr << "parser error : Unterminated processing instruction '" << std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)) << "'\n";
-                return 1;
-            }
-            const std::string_view target(std::addressof(*cursor), std::distance(cursor, nameEnd));
-            cursor = std::find_if_not(nameEnd, tagEnd, isspace);
-            const std::string_view data(std::addressof(*cursor), std::distance(cursor, tagEnd));
-            TRACE("PI", "target", target, "data", data);
-            cursor = tagEnd;
-            std::advance(cursor, 2);
-        } else if (cursor[1] == '/' && *cursor == '<') {
-            // parse end tag
-            if (std::distance(cursor, cursorEnd) < 100) {
-                std::string::const_iterator tagEnd = std::find(cursor, cursorEnd, '>');
-                if (tagEnd == cursorEnd) {
-                    int bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-                    if (bytesRead < 0) {
-                        std::cerr << "parser error : File input error\n";
-                        return 1;
-                    }
-                    totalBytes += bytesRead;
-                    if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd) {
-                        std::cerr << "parser error: Incomplete element end tag\n";
-                        return 1;
-                    }
-                }
-            }
-            std::advance(cursor, 2);
-            if (*cursor == ':') {
-                std::cerr << "parser error : Invalid end tag name\n";
-                return 1;
-            }
-            std::string::const_iterator nameEnd = std::find_if_not(cursor, cursorEnd, [] (char c) { return tagNameMask[c]; });
-            if (nameEnd == cursorEnd) {
-                std::cerr << "parser error : Unterminated end tag '" << std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)) << "'\n";
-                return 1;
-            }
-            size_t colonPosition = 0;
-            if (*nameEnd == ':') {
-                colonPosition = std::distance(cursor, nameEnd);
-                nameEnd = std::find_if_not(std::next(nameEnd), cursorEnd, [] (char c) { return tagNameMask[c]; });
-            }
-            const std::string_view prefix(std::addressof(*cursor), colonPosition);
-            const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
-            if (qName.empty()) {
-                std::cerr << "parser error: EndTag: invalid element name\n";
-                return 1;
-            }
-            if (colonPosition)
-                ++colonPosition;
-            const std::string_view localName(std::addressof(*cursor) + colonPosition, std::distance(cursor, nameEnd) - colonPosition);
-            cursor = std::next(nameEnd);
-            --depth;
-            TRACE("END TAG", "prefix", prefix, "qName", qName, "localName", localName);
-        } else if (*cursor == '<') {
-            // parse start tag
-            if (std::distance(cursor, cursorEnd) < 200) {
-                std::string::const_iterator tagEnd = std::find(cursor, cursorEnd, '>');
-                if (tagEnd == cursorEnd) {
-                    int bytesRead = refillBuffer(cursor, cursorEnd, buffer);
-                    if (bytesRead < 0) {
-                        std::cerr << "parser error : File input error\n";
-                        return 1;
-                    }
-                    totalBytes += bytesRead;
-                    if ((tagEnd = std::find(cursor, cursorEnd, '>')) == cursorEnd) {
-                        std::cerr << "parser error: Incomplete element start tag\n";
-                        return 1;
-                    }
-                }
-            }
-            std::advance(cursor, 1);
-            if (*cursor == ':') {
-                std::cerr << "parser error : Invalid start tag name\n";
-                return 1;
-            }
-            std::string::const_iterator nameEnd = std::find_if_not(cursor, cursorEnd, [] (char c) { return tagNameMask[c]; });
-            if (nameEnd == cursorEnd) {
-                std::cerr << "parser error : Unterminated start tag '" << std::string_view(std::addressof(*cursor), std::distance(cursor, nameEnd)) << "'\n";
-                return 1;
-            }
-            size_t colonPosition = 0;
-            if (*nameEnd == ':') {
-                colonPosition = std::distance(cursor, nameEnd);
-                nameEnd = std::find_if_not(std::next(nameEnd), cursorEnd, [] (char c) { return tagNameMask[c]; });
-            }
-            const std::string_view prefix(std::addressof(*cursor), colonPosition);
-            const std::string_view qName(std::addressof(*cursor), std::distance(cursor, nameEnd));
-            if (qName.empty()) {
-                std::cerr << "parser error: StartTag: invalid element name\n";
+        } catch (const ParseError& error) {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+        return 0;
+#else
+        std::cerr << "srcFacts: --extract-source is not supported on this platform\n";
+        return 1;
+#endif
+    }
+    if (filenamePattern || language) {
+#if !defined(_MSC_VER)
+        UnitFilter filter(filenamePattern ? filenamePattern : "", language ? language : "");
+        try {
+            if (!filter.run(input, 1)) {
+                std::cerr << "srcFacts: Unable to write srcML\n";
                 return 1;
             }
-            if (colonPosition)
-                ++colonPosition;
-            const std::string_view localName(std::addressof(*cursor) + colonPosition, std::distance(cursor, nameEnd) - colonPosition);
-            TRACE("START TAG", "prefix", prefix, "qName", qName, "localName", localName);
-            if (localName == "expr"sv) {
-                ++exprCount;
-            } else if (localName == "decl"sv) {
-                ++declCount;
-            } else if (localName == "comment"sv) {
-                ++commentCount;
-            } else if (localName == "function"sv) {
-                ++functionCount;
-            } else if (localName == "unit"sv) {
-                ++unitCount;
-                if (depth == 1)
-                    isArchive = true;
-            } else if (localName == "class"sv) {
-                ++classCount;
-            }
-            cursor = nameEnd;
-            if (*cursor != '>')
-                cursor = std::find_if_not(cursor, cursorEnd, isspace);
-            if (*cursor == '>') {
-                std::advance(cursor, 1);
-                ++depth;
-            } else if (*cursor == '/' && cursor[1] == '>') {
-                std::advance(cursor, 2);
-                TRACE("END TAG", "prefix", prefix, "qName", qName, "localName", localName);
-            } else {
-                inTagQName = qName;
-                inTagPrefix = std::string_view(inTagQName.data(), prefix.size());
-                inTagLocalName = std::string_view(inTagQName.data() + prefix.size() + 1);
-                inTag = true;
-            }
-        } else if (depth == 0) {
-            // parse characters before or after XML
-            cursor = std::find_if_not(cursor, cursorEnd, isspace);
-        } else if (*cursor == '&') {
-            // parse character entity references
-            std::string_view characters;
-            if (cursor[1] == 'l' && cursor[2] == 't' && cursor[3] == ';') {
-                characters = "<";
-                std::advance(cursor, 4);
-            } else if (cursor[1] == 'g' && cursor[2] == 't' && cursor[3] == ';') {
-                characters = ">";
-                std::advance(cursor, 4);
-            } else if (cursor[1] == 'a' && cursor[2] == 'm' && cursor[3] == 'p' && cursor[4] == ';') {
-                characters = "&";
-                std::advance(cursor, 5);
-            } else {
-                characters = "&";
-                std::advance(cursor, 1);
-            }
-            TRACE("ENTITYREF", "characters", characters);
-            ++textsize;
-
+        } catch (const ParseError& error) {
+            std::cerr << error.what() << '\n';
+            return 1;
+        }
+        return 0;
+#else
+        std::cerr << "srcFacts: --filename and --language are not supported on this platform\n";
+        return 1;
+#endif
+    }
+    Facts facts;
+    std::unique_ptr<CallGraph> callGraph;
+    if (callGraphPath)
+        callGraph = std::make_unique<CallGraph>();
+    std::unique_ptr<ElementHistogram> histogram;
+    if (histogramPath)
+        histogram = std::make_unique<ElementHistogram>();
+    std::unique_ptr<Complexity> complexity;
+    if (complexityPath)
+        complexity = std::make_unique<Complexity>();
+    std::unique_ptr<IdentifierIndexWriter> index;
+    if (indexPath)
+        index = std::make_unique<IdentifierIndexWriter>(indexPath);
+    std::unique_ptr<EventStreamWriter> eventStream;
+    if (isEmitEvents) {
+#if defined(_MSC_VER)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        eventStream = std::make_unique<EventStreamWriter>(std::cout);
+    }
+    // all of the analyses of the events in one pass of the parser
+    EventHandlers handlers(callGraph.get(), histogram.get(), complexity.get(), index.get(), eventStream.get());
+    try {
+        if (!handlers.empty()) {
+            EventGenerator events(input);
+            for (const ParseEvent& event : events)
+                handlers.event(event);
+            facts = events.facts();
+#if !defined(_MSC_VER)
+        } else if (publisher) {
+            // publish the measures so far after each read
+            Analyzer analyzer;
+            try {
+                while (analyzer.read(input) > 0)
+                    publisher->publish(analyzer.facts(), PublishedFacts::RUNNING);
+                facts = analyzer.finish();
+            } catch (const ParseError&) {
+                publisher->publish(analyzer.facts(), PublishedFacts::FAILED);
+                throw;
+            }
+            publisher->publish(facts, PublishedFacts::COMPLETE);
+#endif
         } else {
-            // parse character non-entity references
-            const std::string::const_iterator tagEnd = std::find_if(cursor, cursorEnd, [] (char c) { return c == '<' || c == '&'; });
-            const std::string_view characters(std::addressof(*cursor), std::distance(cursor, tagEnd));
-            TRACE("CHARACTERS", "characters", characters);
-            loc += static_cast<int>(std::count(characters.cbegin(), characters.cend(), '\n'));
-            textsize += static_cast<int>(characters.size());
-            std::advance(cursor, characters.size());
+            facts = analyze(input);
+        }
+    } catch (const ParseError& error) {
+        std::cerr << error.what() << '\n';
+        // downstream tools see the failure at the end of the events
+        if (eventStream)
+            eventStream->finish(EventStreamWriter::FAILED);
+        return 1;
+    }
+    if (callGraph) {
+        std::ofstream callGraphFile(callGraphPath, std::ios::binary);
+        if (isCallGraphBinary)
+            callGraph->writeBinary(callGraphFile);
+        else
+            callGraph->writeCSV(callGraphFile);
+        if (!callGraphFile) {
+            std::cerr << "srcFacts: Unable to write call graph " << callGraphPath << '\n';
+            return 1;
         }
     }
-    TRACE("END DOCUMENT");
+    if (histogram) {
+        std::ofstream histogramFile(histogramPath);
+        histogram->writeCSV(histogramFile);
+        if (!histogramFile) {
+            std::cerr << "srcFacts: Unable to write histogram " << histogramPath << '\n';
+            return 1;
+        }
+    }
+    if (complexity) {
+        std::ofstream complexityFile(complexityPath);
+        complexity->writeCSV(complexityFile);
+        if (!complexityFile) {
+            std::cerr << "srcFacts: Unable to write complexity " << complexityPath << '\n';
+            return 1;
+        }
+    }
+    if (index && !index->finish()) {
+        std::cerr << "srcFacts: Unable to write index " << indexPath << '\n';
+        return 1;
+    }
+    if (eventStream) {
+        if (!eventStream->finish()) {
+            std::cerr << "srcFacts: Unable to write events\n";
+            return 1;
+        }
+        return 0;
+    }
     const auto finish = std::chrono::steady_clock::now();
     const auto elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double> >(finish - start).count();
-    const double mlocPerSec = loc / elapsed_seconds / 1000000;
-    int files = unitCount;
-    if (isArchive)
-        --files;
+    const double mlocPerSec = facts.loc / elapsed_seconds / 1000000;
     std::cout.imbue(std::locale{""});
-    int valueWidth = std::max(5, static_cast<int>(log10(totalBytes) * 1.3 + 1));
-    std::cout << "# srcFacts: " << url << '\n';
+    int valueWidth = std::max(5, static_cast<int>(log10(facts.totalBytes) * 1.3 + 1));
+    std::cout << "# srcFacts: " << facts.url << '\n';
     std::cout << "| Measure      | " << std::setw(valueWidth + 3) << "Value |\n";
     std::cout << "|:-------------|-" << std::setw(valueWidth + 3) << std::setfill('-') << ":|\n" << std::setfill(' ');
-    std::cout << "| srcML bytes  | " << std::setw(valueWidth) << totalBytes          << " |\n";
-    std::cout << "| Characters   | " << std::setw(valueWidth) << textsize       << " |\n";
-    std::cout << "| Files        | " << std::setw(valueWidth) << files          << " |\n";
-    std::cout << "| LOC          | " << std::setw(valueWidth) << loc            << " |\n";
-    std::cout << "| Classes      | " << std::setw(valueWidth) << classCount    << " |\n";
-    std::cout << "| Functions    | " << std::setw(valueWidth) << functionCount << " |\n";
-    std::cout << "| Declarations | " << std::setw(valueWidth) << declCount     << " |\n";
-    std::cout << "| Expressions  | " << std::setw(valueWidth) << exprCount     << " |\n";
-    std::cout << "| Comments     | " << std::setw(valueWidth) << commentCount  << " |\n";
+    std::cout << "| srcML bytes  | " << std::setw(valueWidth) << facts.totalBytes    << " |\n";
+    std::cout << "| Characters   | " << std::setw(valueWidth) << facts.textsize      << " |\n";
+    std::cout << "| Files        | " << std::setw(valueWidth) << facts.files()       << " |\n";
+    std::cout << "| LOC          | " << std::setw(valueWidth) << facts.loc           << " |\n";
+    std::cout << "| Classes      | " << std::setw(valueWidth) << facts.classCount    << " |\n";
+    std::cout << "| Functions    | " << std::setw(valueWidth) << facts.functionCount << " |\n";
+    std::cout << "| Declarations | " << std::setw(valueWidth) << facts.declCount     << " |\n";
+    std::cout << "| Expressions  | " << std::setw(valueWidth) << facts.exprCount     << " |\n";
+    std::cout << "| Comments     | " << std::setw(valueWidth) << facts.commentCount  << " |\n";
     std::clog << '\n';
     std::clog << std::setprecision(3) << elapsed_seconds << " sec\n";
     std::clog << std::setprecision(3) << mlocPerSec << " MLOC/sec\n";
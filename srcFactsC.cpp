@@ -0,0 +1,136 @@
+/*
+    srcFactsC.cpp
+
+    C interface to the srcfacts library.
+*/
+
+#include "srcFactsC.h"
+#include "analyze.hpp"
+#include <string>
+#include <string_view>
+#include <new>
+#include <algorithm>
+#include <cstring>
+
+struct sf_analyzer {
+    Analyzer analyzer;
+    int status = SF_OK;
+    std::string error;
+};
+
+namespace {
+
+    /*
+        Run an analyzer operation, converting exceptions to a status
+
+        @param[in,out] analyzer Analyzer
+        @param[in] operation Operation on the C++ analyzer
+        @return Status of the operation, or an earlier error
+    */
+    template <typename Operation>
+    int guard(sf_analyzer* analyzer, Operation operation) noexcept {
+        if (!analyzer)
+            return SF_ERROR_ARGUMENT;
+        if (analyzer->status != SF_OK)
+            return analyzer->status;
+        try {
+            operation(analyzer->analyzer);
+        } catch (const ParseError& error) {
+            analyzer->status = SF_ERROR_PARSE;
+            try {
+                analyzer->error = error.what();
+            } catch (...) {
+            }
+        } catch (const std::bad_alloc&) {
+            analyzer->status = SF_ERROR_MEMORY;
+        } catch (...) {
+            analyzer->status = SF_ERROR_PARSE;
+        }
+        return analyzer->status;
+    }
+
+    /*
+        Copy a string as a null-terminated string, truncated to fit
+
+        @param[in] s String
+        @param[out] buffer Buffer
+        @param[in] size Size of the buffer
+        @return Length of the full string
+    */
+    size_t copyString(std::string_view s, char* buffer, size_t size) noexcept {
+        if (buffer && size > 0) {
+            const size_t length = std::min(s.size(), size - 1);
+            std::memcpy(buffer, s.data(), length);
+            buffer[length] = '\0';
+        }
+        return s.size();
+    }
+}
+
+sf_analyzer* sf_analyzer_new(void) {
+    // the analyzer buffer is allocated by the constructor
+    try {
+        return new sf_analyzer;
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void sf_analyzer_free(sf_analyzer* analyzer) {
+    delete analyzer;
+}
+
+void sf_reset(sf_analyzer* analyzer) {
+    if (!analyzer)
+        return;
+    analyzer->analyzer.reset();
+    analyzer->status = SF_OK;
+    analyzer->error.clear();
+}
+
+int sf_feed(sf_analyzer* analyzer, const char* data, size_t size) {
+    if (!data && size > 0)
+        return SF_ERROR_ARGUMENT;
+    return guard(analyzer, [=](Analyzer& a) { a.feed(data, size); });
+}
+
+int sf_finish(sf_analyzer* analyzer) {
+    return guard(analyzer, [](Analyzer& a) { a.finish(); });
+}
+
+int sf_facts_get(const sf_analyzer* analyzer, sf_facts* facts, size_t size) {
+    if (!analyzer || !facts || size == 0)
+        return SF_ERROR_ARGUMENT;
+    const Facts& counts = analyzer->analyzer.facts();
+    sf_facts current{};
+    current.total_bytes = counts.totalBytes;
+    current.textsize = counts.textsize;
+    current.loc = counts.loc;
+    current.expr_count = counts.exprCount;
+    current.function_count = counts.functionCount;
+    current.class_count = counts.classCount;
+    current.unit_count = counts.unitCount;
+    current.decl_count = counts.declCount;
+    current.comment_count = counts.commentCount;
+    current.is_archive = counts.isArchive;
+    current.files = counts.files();
+
+    // fields beyond the struct of the caller, from a newer header, are not written
+    std::memcpy(facts, &current, std::min(size, sizeof(current)));
+    return SF_OK;
+}
+
+size_t sf_url_get(const sf_analyzer* analyzer, char* buffer, size_t size) {
+    if (!analyzer)
+        return copyString("", buffer, size);
+    return copyString(analyzer->analyzer.facts().url, buffer, size);
+}
+
+size_t sf_error_get(const sf_analyzer* analyzer, char* buffer, size_t size) {
+    if (!analyzer)
+        return copyString("", buffer, size);
+    // no allocation for the message when out of memory
+    if (analyzer->status == SF_ERROR_MEMORY)
+        return copyString("srcFacts: Out of memory", buffer, size);
+    return copyString(analyzer->error, buffer, size);
+}
@@ -0,0 +1,129 @@
+/*
+    srcFactsC.h
+
+    C interface to the srcfacts library, for use from other languages,
+    e.g., Go with cgo or Python with ctypes.
+
+    All memory passed in is owned by the caller, and no C++ exceptions
+    cross the interface. Errors are reported with status codes, with the
+    message available from sf_error_get().
+*/
+
+#ifndef INCLUDED_SRCFACTSC_H
+#define INCLUDED_SRCFACTSC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Opaque analyzer of a srcML document */
+typedef struct sf_analyzer sf_analyzer;
+
+/* Status codes */
+enum {
+    SF_OK = 0,
+    SF_ERROR_PARSE = 1,
+    SF_ERROR_MEMORY = 2,
+    SF_ERROR_ARGUMENT = 3
+};
+
+/*
+    Measures of source code from srcML.
+    New fields are only added at the end, and sf_facts_get() only writes the
+    fields within the size of the struct of the caller.
+*/
+typedef struct sf_facts {
+    long long total_bytes;
+    int textsize;
+    int loc;
+    int expr_count;
+    int function_count;
+    int class_count;
+    int unit_count;
+    int decl_count;
+    int comment_count;
+    int is_archive;
+    int files;
+} sf_facts;
+
+/*
+    Create an analyzer
+
+    @return Analyzer, or NULL if out of memory
+*/
+sf_analyzer* sf_analyzer_new(void);
+
+/*
+    Free an analyzer
+
+    @param[in] analyzer Analyzer, may be NULL
+*/
+void sf_analyzer_free(sf_analyzer* analyzer);
+
+/*
+    Reset for a new document, keeping the buffer. Also clears an error.
+
+    @param[in,out] analyzer Analyzer
+*/
+void sf_reset(sf_analyzer* analyzer);
+
+/*
+    Parse the next chunk of the document. Tokens may be split anywhere
+    across chunks. The data is not used after the call returns.
+
+    @param[in,out] analyzer Analyzer
+    @param[in] data Next part of the srcML document
+    @param[in] size Number of bytes of data
+    @return SF_OK, or the error status, which stays until sf_reset()
+*/
+int sf_feed(sf_analyzer* analyzer, const char* data, size_t size);
+
+/*
+    Parse the rest of the document after the last chunk
+
+    @param[in,out] analyzer Analyzer
+    @return SF_OK, or the error status, which stays until sf_reset()
+*/
+int sf_finish(sf_analyzer* analyzer);
+
+/*
+    Copy the measures so far, e.g., sf_facts_get(analyzer, &facts, sizeof(facts)).
+    A caller compiled with an older header passes the size of its smaller
+    struct, and only those fields are written.
+
+    @param[in] analyzer Analyzer
+    @param[out] facts Measures of the document
+    @param[in] size Size of the struct of the caller, sizeof(sf_facts)
+    @return SF_OK or SF_ERROR_ARGUMENT
+*/
+int sf_facts_get(const sf_analyzer* analyzer, sf_facts* facts, size_t size);
+
+/*
+    Copy the url of the document as a null-terminated string, truncated
+    to fit the buffer
+
+    @param[in] analyzer Analyzer
+    @param[out] buffer Buffer for the url, may be NULL when size is 0
+    @param[in] size Size of the buffer
+    @return Length of the full url, not including the null
+*/
+size_t sf_url_get(const sf_analyzer* analyzer, char* buffer, size_t size);
+
+/*
+    Copy the message of the last error as a null-terminated string,
+    truncated to fit the buffer
+
+    @param[in] analyzer Analyzer
+    @param[out] buffer Buffer for the message, may be NULL when size is 0
+    @param[in] size Size of the buffer
+    @return Length of the full message, not including the null, 0 if no error
+*/
+size_t sf_error_get(const sf_analyzer* analyzer, char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+/*
+    srcFactsCTest.c
+
+    Use of the C interface from C, for the tests of srcFacts.
+*/
+
+#include "srcFactsC.h"
+
+/*
+    Analyze srcML through the C interface, fed a few bytes at a time
+
+    @param[in] srcML srcML document
+    @param[in] size Number of bytes of srcML
+    @param[in] chunkSize Number of bytes in each feed
+    @param[out] facts Measures of the srcML
+    @return SF_OK, or the error status
+*/
+int analyzeC(const char* srcML, size_t size, size_t chunkSize, sf_facts* facts) {
+    sf_analyzer* analyzer = sf_analyzer_new();
+    if (!analyzer)
+        return SF_ERROR_MEMORY;
+    int status = SF_OK;
+    for (size_t offset = 0; offset < size && status == SF_OK; offset += chunkSize)
+        status = sf_feed(analyzer, srcML + offset, size - offset < chunkSize ? size - offset : chunkSize);
+    if (status == SF_OK)
+        status = sf_finish(analyzer);
+    if (status == SF_OK)
+        status = sf_facts_get(analyzer, facts, sizeof(*facts));
+    sf_analyzer_free(analyzer);
+    return status;
+}
@@ -0,0 +1,355 @@
+/*
+    srcFactsTest.cpp
+
+    Tests of srcFacts, each run by name from ctest, e.g., srcFactsTest feed.
+    Without a name, all of the tests are run.
+*/
+
+#include "analyze.hpp"
+#include "eventGenerator.hpp"
+#include "eventStream.hpp"
+#include "identifierIndex.hpp"
+#include "parseEvent.hpp"
+#include "srcFactsC.h"
+#if !defined(_MSC_VER)
+#include "unitFilter.hpp"
+#include "unitScan.hpp"
+#endif
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+// analysis through the C interface, in srcFactsCTest.c
+extern "C" int analyzeC(const char* srcML, size_t size, size_t chunkSize, sf_facts* facts);
+
+namespace {
+
+    // archive of two units, with text between them, and a '>' in a filename
+    constexpr std::string_view ARCHIVE = R"(<?xml version="1.0" encoding="UTF-8" standalone="yes"?>
+<unit xmlns="http://www.srcML.org/srcML/src" revision="1.0.0" url="demo">
+
+<unit revision="1.0.0" language="C++" filename="a>b.cpp"><function><type><name>int</name></type> <name>main</name><parameter_list>()</parameter_list> <block>{<block_content>
+    <return>return <expr><name>x</name> <operator>+</operator> <literal type="number">1</literal></expr>;</return>
+</block_content>}</block></function>
+</unit>
+
+<unit revision="1.0.0" language="Java" filename="B.java"><class>class <name>B</name> <block>{
+    <comment type="line">// x</comment>
+    <decl_stmt><decl><type><name>int</name></type> <name>x</name></decl>;</decl_stmt>
+}</block></class>
+</unit>
+
+</unit>
+)"sv;
+
+    // archive cut short, without the end tags of its last unit and of the root unit
+    constexpr std::string_view TRUNCATED = "<unit>\n<unit filename=\"a\"><expr/>\n<unit filename=\"b\"><expr/>"sv;
+
+    int failures = 0;
+
+    /*
+        Report a failed check
+
+        @param[in] isPassed Whether the check passed
+        @param[in] check Text of the check
+        @param[in] line Line of the check
+    */
+    void report(bool isPassed, const char* check, int line) {
+        if (isPassed)
+            return;
+        std::cerr << "srcFactsTest: Failed line " << line << ": " << check << '\n';
+        ++failures;
+    }
+
+#define CHECK(condition) report(condition, #condition, __LINE__)
+
+    /*
+        Whether two measures are the same
+
+        @param[in] first Measures of the srcML
+        @param[in] second Measures of the srcML
+        @return Whether every measure is the same
+    */
+    bool isSame(const Facts& first, const Facts& second) {
+        return first.url == second.url && first.totalBytes == second.totalBytes
+            && first.textsize == second.textsize && first.loc == second.loc
+            && first.exprCount == second.exprCount && first.functionCount == second.functionCount
+            && first.classCount == second.classCount && first.unitCount == second.unitCount
+            && first.declCount == second.declCount && first.commentCount == second.commentCount
+            && first.isArchive == second.isArchive;
+    }
+
+    // chunks fed with tokens split at every position are the same as the whole document
+    void testFeed() {
+        const Facts facts = analyze(ARCHIVE);
+        CHECK(facts.url == "demo");
+        CHECK(facts.files() == 2);
+        CHECK(facts.loc == 13);
+        CHECK(facts.functionCount == 1);
+        CHECK(facts.classCount == 1);
+        CHECK(facts.declCount == 1);
+        CHECK(facts.commentCount == 1);
+        CHECK(facts.totalBytes == static_cast<long>(ARCHIVE.size()));
+
+        StringSource input(ARCHIVE);
+        CHECK(isSame(analyze(input), facts));
+
+        for (const std::size_t chunkSize : { 1, 2, 3, 7, 64 }) {
+            Analyzer analyzer;
+            for (std::size_t offset = 0; offset < ARCHIVE.size(); offset += chunkSize)
+                analyzer.feed(ARCHIVE.substr(offset, chunkSize));
+            CHECK(isSame(analyzer.finish(), facts));
+            CHECK(analyzer.isComplete());
+        }
+
+        // the events and parsed srcML of a feed are those of its chunk
+        Analyzer analyzer;
+        std::vector<ParseEvent> events;
+        analyzer.recordEvents(&events);
+        analyzer.feed("<unit><na"sv);
+        CHECK(analyzer.parsed() == "<unit>"sv);
+        CHECK(events.size() == 1 && events[0].type == ParseEvent::START_TAG && events[0].name == "unit"sv);
+        analyzer.feed("me>i</name></unit>"sv);
+        CHECK(analyzer.parsed() == "<name>i</name></unit>"sv);
+        CHECK(events.size() == 4 && events[0].name == "name"sv && events[1].value == "i"sv);
+        analyzer.finish();
+        CHECK(analyzer.isComplete());
+    }
+
+    // the C interface from C is the same as the C++ interface
+    void testCInterface() {
+        const Facts facts = analyze(ARCHIVE);
+        for (const std::size_t chunkSize : { 1, 5, 4096 }) {
+            sf_facts cFacts{};
+            CHECK(analyzeC(ARCHIVE.data(), ARCHIVE.size(), chunkSize, &cFacts) == SF_OK);
+            CHECK(cFacts.total_bytes == facts.totalBytes);
+            CHECK(cFacts.textsize == facts.textsize);
+            CHECK(cFacts.loc == facts.loc);
+            CHECK(cFacts.expr_count == facts.exprCount);
+            CHECK(cFacts.function_count == facts.functionCount);
+            CHECK(cFacts.class_count == facts.classCount);
+            CHECK(cFacts.unit_count == facts.unitCount);
+            CHECK(cFacts.decl_count == facts.declCount);
+            CHECK(cFacts.comment_count == facts.commentCount);
+            CHECK(cFacts.is_archive == 1);
+            CHECK(cFacts.files == 2);
+        }
+
+        // a caller with an older, smaller struct gets only its fields
+        sf_analyzer* analyzer = sf_analyzer_new();
+        CHECK(sf_feed(analyzer, ARCHIVE.data(), ARCHIVE.size()) == SF_OK);
+        CHECK(sf_finish(analyzer) == SF_OK);
+        sf_facts older{};
+        older.files = -1;
+        CHECK(sf_facts_get(analyzer, &older, offsetof(sf_facts, files)) == SF_OK);
+        CHECK(older.loc == facts.loc);
+        CHECK(older.files == -1);
+        CHECK(sf_facts_get(analyzer, nullptr, sizeof(sf_facts)) == SF_ERROR_ARGUMENT);
+
+        // the url is truncated to the buffer
+        char url[3];
+        CHECK(sf_url_get(analyzer, url, sizeof(url)) == 4);
+        CHECK(std::strcmp(url, "de") == 0);
+        CHECK(sf_error_get(analyzer, nullptr, 0) == 0);
+
+        // an error stays until a reset
+        sf_reset(analyzer);
+        const std::string_view invalid = "<unit><expr"sv;
+        CHECK(sf_feed(analyzer, invalid.data(), invalid.size()) == SF_OK);
+        CHECK(sf_finish(analyzer) == SF_ERROR_PARSE);
+        CHECK(sf_error_get(analyzer, nullptr, 0) > 0);
+        CHECK(sf_feed(analyzer, "<unit/>", 7) == SF_ERROR_PARSE);
+        sf_reset(analyzer);
+        CHECK(sf_error_get(analyzer, nullptr, 0) == 0);
+        sf_analyzer_free(analyzer);
+    }
+
+    // event stream header, records, and the END record with the status
+    void testEventStream() {
+        std::ostringstream out;
+        EventStreamWriter writer(out);
+        StringSource input(ARCHIVE);
+        EventGenerator events(input);
+        for (const ParseEvent& event : events)
+            writer.event(event);
+        CHECK(writer.finish());
+        const std::string stream = out.str();
+        CHECK(stream.compare(0, 4, "SFEV") == 0);
+        CHECK(stream.size() > 7 && stream[4] == 2);
+        CHECK(stream.size() > 7 && stream[5] == ParseEvent::XML_DECLARATION);
+        CHECK(stream.size() > 7 && stream[stream.size() - 2] == EventStreamWriter::END);
+        CHECK(stream.size() > 7 && stream.back() == EventStreamWriter::COMPLETE);
+
+        // a failed document is only the header and the END record
+        std::ostringstream failedOut;
+        EventStreamWriter failed(failedOut);
+        CHECK(failed.finish(EventStreamWriter::FAILED));
+        CHECK(failedOut.str() == std::string("SFEV\x02\x0a\x01", 7));
+    }
+
+    // index merged from several runs, and lookups of it
+    void testIdentifierIndex() {
+        const std::string path = "srcFactsTest.idx";
+        {
+            // a run for every 2 postings, so the index is a merge of runs
+            IdentifierIndexWriter index(path, 2);
+            StringSource input(ARCHIVE);
+            EventGenerator events(input);
+            for (const ParseEvent& event : events)
+                index.event(event);
+            CHECK(index.finish());
+        }
+        std::ostringstream uses;
+        CHECK(lookupIdentifier(path, "x", uses) == 2);
+        CHECK(uses.str() == "a>b.cpp:2\nB.java:3\n");
+        uses.str("");
+        CHECK(lookupIdentifier(path, "int", uses) == 2);
+        CHECK(uses.str() == "a>b.cpp:1\nB.java:3\n");
+        uses.str("");
+        CHECK(lookupIdentifier(path, "main", uses) == 1);
+        CHECK(uses.str() == "a>b.cpp:1\n");
+        uses.str("");
+        CHECK(lookupIdentifier(path, "y", uses) == 0);
+        CHECK(uses.str().empty());
+        CHECK(std::ifstream(path + ".run0").fail());
+
+        // an index with an invalid length is an error, not an allocation of the length
+        std::string corrupt;
+        {
+            std::ifstream in(path, std::ios::binary);
+            corrupt.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        CHECK(corrupt.size() > 8);
+        if (corrupt.size() > 8)
+            corrupt.replace(4, 4, "\xff\xff\xff\x7f", 4);
+        std::ofstream(path, std::ios::binary) << corrupt;
+        CHECK(lookupIdentifier(path, "B", uses) == -1);
+        std::ofstream(path, std::ios::binary) << "SFIX";
+        CHECK(lookupIdentifier(path, "B", uses) == -1);
+        std::remove(path.c_str());
+    }
+
+#if !defined(_MSC_VER)
+    // units of an archive, without the text between them, and of a truncated archive
+    void testUnitScan() {
+        const std::vector<std::string_view> units = findUnits(ARCHIVE);
+        CHECK(units.size() == 2);
+        if (units.size() != 2)
+            return;
+        CHECK(units[0].substr(0, 5) == "<unit"sv && units[0].substr(units[0].size() - 7) == "</unit>"sv);
+        CHECK(units[1].substr(0, 5) == "<unit"sv && units[1].substr(units[1].size() - 7) == "</unit>"sv);
+
+        // a '>' in an attribute value is not the end of the start tag
+        CHECK(units[0].substr(0, startTagEnd(units[0])) == R"(<unit revision="1.0.0" language="C++" filename="a>b.cpp">)"sv);
+        CHECK(startTagEnd("<unit filename='>'"sv) == 18);
+
+        // the units and the text outside of them are the whole archive
+        const Facts facts = analyze(ARCHIVE);
+        const Facts outside = analyze(outsideUnits(ARCHIVE, units));
+        const Facts first = analyze(units[0]);
+        const Facts second = analyze(units[1]);
+        CHECK(outside.loc + first.loc + second.loc == facts.loc);
+        CHECK(outside.textsize + first.textsize + second.textsize == facts.textsize);
+
+        // a truncated archive ends at the end of the input
+        const std::vector<std::string_view> truncated = findUnits(TRUNCATED);
+        CHECK(truncated.size() == 2);
+        CHECK(truncated.size() == 2 && truncated[0] == "<unit filename=\"a\"><expr/>"sv);
+        CHECK(truncated.size() == 2 && truncated[1] == "<unit filename=\"b\"><expr/>"sv);
+
+        // a single unit is the whole document
+        const std::string_view single = "<unit><expr/></unit>\n"sv;
+        const std::vector<std::string_view> singleUnits = findUnits(single);
+        CHECK(singleUnits.size() == 1 && singleUnits[0] == single);
+        CHECK(outsideUnits(single, singleUnits).empty());
+    }
+
+    /*
+        Output of a unit filter of the archive
+
+        @param[in] filenamePattern Glob of the filenames of the units to keep
+        @param[in] language Language of the units to keep
+        @return Filtered srcML
+    */
+    std::string filter(const char* filenamePattern, const char* language) {
+        std::FILE* file = std::tmpfile();
+        if (!file)
+            return "";
+        UnitFilter unitFilter(filenamePattern, language);
+        StringSource input(ARCHIVE);
+        const bool isWritten = unitFilter.run(input, fileno(file));
+        std::string output;
+        std::rewind(file);
+        char buffer[4096];
+        std::size_t readBytes = 0;
+        while ((readBytes = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            output.append(buffer, readBytes);
+        std::fclose(file);
+        return isWritten ? output : "";
+    }
+
+    // units kept and skipped by filename and language, with a '>' in a filename
+    void testUnitFilter() {
+        const std::vector<std::string_view> units = findUnits(ARCHIVE);
+        CHECK(units.size() == 2);
+        if (units.size() != 2)
+            return;
+        const std::size_t firstStart = units[0].data() - ARCHIVE.data();
+        const std::size_t secondStart = units[1].data() - ARCHIVE.data();
+
+        // skipping the unit with the '>' in its filename
+        const std::string java = filter("*.java", "");
+        CHECK(java == std::string(ARCHIVE.substr(0, firstStart)) + std::string(ARCHIVE.substr(secondStart)));
+        CHECK(filter("", "Java") == java);
+
+        // keeping it
+        const std::string cpp = filter("a>b.*", "");
+        CHECK(cpp == std::string(ARCHIVE.substr(0, secondStart)) + "</unit>\n");
+        CHECK(filter("", "C++") == cpp);
+
+        // all, and none
+        CHECK(filter("", "") == ARCHIVE);
+        CHECK(filter("*.c", "") == std::string(ARCHIVE.substr(0, firstStart)) + "</unit>\n");
+    }
+#endif
+
+    // tests by name
+    struct Test {
+        const char* name;
+        void (*run)();
+    };
+    const Test TESTS[] = {
+        { "feed", testFeed },
+        { "c-interface", testCInterface },
+        { "event-stream", testEventStream },
+        { "identifier-index", testIdentifierIndex },
+#if !defined(_MSC_VER)
+        { "unit-scan", testUnitScan },
+        { "unit-filter", testUnitFilter },
+#endif
+    };
+}
+
+int main(int argc, char* argv[]) {
+    bool isFound = false;
+    for (const Test& test : TESTS) {
+        if (argc > 1 && std::strcmp(argv[1], test.name) != 0)
+            continue;
+        isFound = true;
+        test.run();
+    }
+    if (!isFound) {
+        std::cerr << "srcFactsTest: Unknown test " << argv[1] << '\n';
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
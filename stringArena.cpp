@@ -0,0 +1,105 @@
+/*
+    stringArena.cpp
+
+    Arena of deduplicated strings that outlive the parser buffer.
+*/
+
+#include "stringArena.hpp"
+#include <functional>
+#include <algorithm>
+#include <cstring>
+
+StringArena::StringArena(std::size_t blockSize)
+    : blockSize(blockSize), table(1024) {
+}
+
+/*
+    Copy of a string in the arena, shared by equal strings
+
+    @param[in] s String, e.g., a view into the parser buffer
+    @return View of the copy, valid until reset()
+*/
+std::string_view StringArena::intern(std::string_view s) {
+    const std::size_t mask = table.size() - 1;
+    std::size_t position = std::hash<std::string_view>()(s) & mask;
+    while (table[position].data() != nullptr) {
+        if (table[position] == s)
+            return table[position];
+        position = (position + 1) & mask;
+    }
+
+    // copy of a new string, with the empty string still given a non-null address
+    char* copy = allocate(std::max<std::size_t>(s.size(), 1));
+    std::memcpy(copy, s.data(), s.size());
+    table[position] = std::string_view(copy, s.size());
+    ++count;
+    const std::string_view result = table[position];
+    if (count * 2 > table.size())
+        grow();
+    return result;
+}
+
+/*
+    Free all strings, keeping the memory for reuse
+*/
+void StringArena::reset() {
+    std::fill(table.begin(), table.end(), std::string_view());
+    count = 0;
+    currentBlock = 0;
+    next = blocks.empty() ? nullptr : blocks[0].get();
+    end = blocks.empty() ? nullptr : next + blockSizes[0];
+}
+
+/*
+    Memory for a string, from the current block or a new one
+
+    @param[in] size Number of bytes
+    @return Start of the memory
+*/
+char* StringArena::allocate(std::size_t size) {
+    if (static_cast<std::size_t>(end - next) < size) {
+        // next kept block that fits, or a new block
+        if (!blocks.empty())
+            ++currentBlock;
+        while (currentBlock < blocks.size() && blockSizes[currentBlock] < size)
+            ++currentBlock;
+        if (currentBlock >= blocks.size()) {
+            const std::size_t newSize = std::max(blockSize, size);
+            blocks.emplace_back(new char[newSize]);
+            blockSizes.push_back(newSize);
+            currentBlock = blocks.size() - 1;
+        }
+        next = blocks[currentBlock].get();
+        end = next + blockSizes[currentBlock];
+    }
+    char* result = next;
+    next += size;
+    return result;
+}
+
+/*
+    Double the hash table
+*/
+void StringArena::grow() {
+    std::vector<std::string_view> oldTable(table.size() * 2);
+    oldTable.swap(table);
+    const std::size_t mask = table.size() - 1;
+    for (const std::string_view s : oldTable) {
+        if (s.data() == nullptr)
+            continue;
+        std::size_t position = std::hash<std::string_view>()(s) & mask;
+        while (table[position].data() != nullptr)
+            position = (position + 1) & mask;
+        table[position] = s;
+    }
+}
+
+/*
+    Arena of the current thread
+
+    @return Arena of the thread
+*/
+StringArena& threadStringArena() {
+    thread_local StringArena arena;
+    return arena;
+}
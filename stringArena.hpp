@@ -0,0 +1,68 @@
+/*
+    stringArena.hpp
+
+    Arena of deduplicated strings that outlive the parser buffer, e.g.,
+    function names kept for a report.
+*/
+
+#ifndef INCLUDED_STRINGARENA_HPP
+#define INCLUDED_STRINGARENA_HPP
+
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+/*
+    Bump allocator for retained strings, with deduplication. Memory is
+    allocated in large blocks, and all strings are freed at once by reset(),
+    which keeps the blocks for reuse.
+*/
+class StringArena {
+public:
+    explicit StringArena(std::size_t blockSize = 64 * 1024);
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    /*
+        Copy of a string in the arena, shared by equal strings
+
+        @param[in] s String, e.g., a view into the parser buffer
+        @return View of the copy, valid until reset()
+    */
+    std::string_view intern(std::string_view s);
+
+    /*
+        Free all strings, keeping the memory for reuse
+    */
+    void reset();
+
+    // number of distinct strings
+    std::size_t size() const {
+        return count;
+    }
+
+private:
+    char* allocate(std::size_t size);
+    void grow();
+
+    std::size_t blockSize;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<std::size_t> blockSizes;
+    std::size_t currentBlock = 0;
+    char* next = nullptr;
+    char* end = nullptr;
+
+    // open addressing hash table of the strings, with a null data() for an empty slot
+    std::vector<std::string_view> table;
+    std::size_t count = 0;
+};
+
+/*
+    Arena of the current thread
+
+    @return Arena of the thread
+*/
+StringArena& threadStringArena();
+
+#endif
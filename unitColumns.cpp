@@ -0,0 +1,202 @@
+/*
+    unitColumns.cpp
+
+    Columnar file of the measures of each unit, for queries over mapped
+    columns instead of parsing CSV.
+
+    Values are buffered in blocks of units per column, and each block is
+    written at its place in the column with pwrite(), so memory stays
+    bounded for any number of units. Strings are appended to the table
+    after the columns.
+*/
+
+#include "unitColumns.hpp"
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+    const uint32_t UNIT_COLUMNS_VERSION = 1;
+
+    // columns in order, with the STRING columns after the INT64 columns
+    const struct {
+        const char* name;
+        UnitColumnsWriter::Kind kind;
+    } COLUMNS[] = {
+        { "bytes", UnitColumnsWriter::INT64 },
+        { "characters", UnitColumnsWriter::INT64 },
+        { "loc", UnitColumnsWriter::INT64 },
+        { "classes", UnitColumnsWriter::INT64 },
+        { "functions", UnitColumnsWriter::INT64 },
+        { "declarations", UnitColumnsWriter::INT64 },
+        { "expressions", UnitColumnsWriter::INT64 },
+        { "comments", UnitColumnsWriter::INT64 },
+        { "filename", UnitColumnsWriter::STRING },
+        { "url", UnitColumnsWriter::STRING },
+    };
+    const std::size_t COLUMN_COUNT = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+
+    const std::size_t HEADER_SIZE = 40;
+    const std::size_t DIRECTORY_ENTRY_SIZE = 32;
+
+    // units in each block of the columns
+    const std::size_t BLOCK_UNITS = 4096;
+
+    // string table is written in parts of at least this size
+    const std::size_t STRINGS_BLOCK = 1024 * 1024;
+
+    // int64 values of each unit in a column
+    std::size_t columnWidth(UnitColumnsWriter::Kind kind) {
+        return kind == UnitColumnsWriter::STRING ? 2 : 1;
+    }
+
+    uint64_t align64(uint64_t offset) {
+        return (offset + 63) & ~static_cast<uint64_t>(63);
+    }
+
+    /*
+        Write all of the data at an offset, resuming partial and interrupted writes
+
+        @param[in] fd File descriptor
+        @param[in] data Data to write
+        @param[in] size Number of bytes
+        @param[in] offset Offset in the file
+        @return Whether all data was written
+    */
+    bool pwriteAll(int fd, const void* data, std::size_t size, uint64_t offset) {
+        const char* next = static_cast<const char*>(data);
+        while (size > 0) {
+            const ssize_t written = pwrite(fd, next, size, static_cast<off_t>(offset));
+            if (written == -1 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            next += written;
+            size -= written;
+            offset += written;
+        }
+        return true;
+    }
+}
+
+/*
+    Create the file, with space for the columns of all units
+
+    @param[in] path Path of the file
+    @param[in] unitCount Number of units
+*/
+UnitColumnsWriter::UnitColumnsWriter(const char* path, std::size_t unitCount)
+    : unitCount(unitCount), values(COLUMN_COUNT) {
+    while ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1 && errno == EINTR) {
+    }
+    uint64_t offset = align64(HEADER_SIZE + COLUMN_COUNT * DIRECTORY_ENTRY_SIZE);
+    for (std::size_t column = 0; column < COLUMN_COUNT; ++column) {
+        offsets.push_back(offset);
+        offset = align64(offset + unitCount * columnWidth(COLUMNS[column].kind) * sizeof(int64_t));
+        values[column].reserve(BLOCK_UNITS * columnWidth(COLUMNS[column].kind));
+    }
+    stringsOffset = offset;
+}
+
+UnitColumnsWriter::~UnitColumnsWriter() {
+    if (fd != -1)
+        close(fd);
+}
+
+/*
+    Add the measures of the next unit
+
+    @param[in] facts Measures of the unit
+    @param[in] filename Filename of the unit
+    @return Whether the writes succeeded
+*/
+bool UnitColumnsWriter::add(const Facts& facts, std::string_view filename) {
+    if (added == unitCount)
+        return false;
+    values[0].push_back(facts.totalBytes);
+    values[1].push_back(facts.textsize);
+    values[2].push_back(facts.loc);
+    values[3].push_back(facts.classCount);
+    values[4].push_back(facts.functionCount);
+    values[5].push_back(facts.declCount);
+    values[6].push_back(facts.exprCount);
+    values[7].push_back(facts.commentCount);
+    const std::string_view unitStrings[] = { filename, facts.url };
+    for (std::size_t i = 0; i < 2; ++i) {
+        values[8 + i].push_back(static_cast<int64_t>(stringsSize + strings.size()));
+        values[8 + i].push_back(static_cast<int64_t>(unitStrings[i].size()));
+        strings.append(unitStrings[i]);
+    }
+    ++added;
+    if (strings.size() >= STRINGS_BLOCK && !writeStrings())
+        return false;
+    return added - blockStart < BLOCK_UNITS || writeBlock();
+}
+
+/*
+    Write the buffered block of each column at its place in the column
+
+    @return Whether the block was written
+*/
+bool UnitColumnsWriter::writeBlock() {
+    for (std::size_t column = 0; column < COLUMN_COUNT; ++column) {
+        const uint64_t offset = offsets[column] + blockStart * columnWidth(COLUMNS[column].kind) * sizeof(int64_t);
+        if (!pwriteAll(fd, values[column].data(), values[column].size() * sizeof(int64_t), offset))
+            return false;
+        values[column].clear();
+    }
+    blockStart = added;
+    return true;
+}
+
+/*
+    Append the buffered strings to the string table
+
+    @return Whether the strings were written
+*/
+bool UnitColumnsWriter::writeStrings() {
+    if (!pwriteAll(fd, strings.data(), strings.size(), stringsOffset + stringsSize))
+        return false;
+    stringsSize += strings.size();
+    strings.clear();
+    return true;
+}
+
+/*
+    Write the rest of the columns and the header
+
+    @return Whether all of the file was written
+*/
+bool UnitColumnsWriter::finish() {
+    if (!writeBlock() || !writeStrings())
+        return false;
+
+    // the header is last, so a file is only valid once complete
+    std::string header(HEADER_SIZE + COLUMN_COUNT * DIRECTORY_ENTRY_SIZE, '\0');
+    char* next = &header[0];
+    const auto put = [&next](const auto& value) {
+        std::memcpy(next, &value, sizeof(value));
+        next += sizeof(value);
+    };
+    std::memcpy(next, "SFPU", 4);
+    next += 4;
+    put(UNIT_COLUMNS_VERSION);
+    put(static_cast<uint64_t>(added));
+    put(stringsOffset);
+    put(stringsSize);
+    put(static_cast<uint32_t>(COLUMN_COUNT));
+    put(static_cast<uint32_t>(0));
+    for (std::size_t column = 0; column < COLUMN_COUNT; ++column) {
+        std::strncpy(next, COLUMNS[column].name, 16);
+        next += 16;
+        put(static_cast<uint32_t>(COLUMNS[column].kind));
+        put(static_cast<uint32_t>(0));
+        put(offsets[column]);
+    }
+    if (stringsSize == 0 && ftruncate(fd, static_cast<off_t>(stringsOffset)) == -1)
+        return false;
+    return pwriteAll(fd, header.data(), header.size(), 0);
+}
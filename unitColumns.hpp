@@ -0,0 +1,89 @@
+/*
+    unitColumns.hpp
+
+    Columnar file of the measures of each unit, for queries over mapped
+    columns instead of parsing CSV.
+*/
+
+#ifndef INCLUDED_UNITCOLUMNS_HPP
+#define INCLUDED_UNITCOLUMNS_HPP
+
+#include "analyze.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+    Writer of the measures of the units in archive order as a columnar file.
+
+    File format, in native byte order, with each column aligned to 64 bytes:
+    * header of "SFPU", uint32 version, uint64 unit count, uint64 offset and
+      uint64 size of the string table, and uint32 column count and uint32 0
+    * directory of the columns, each a 16-byte name padded with '\0', uint32
+      kind, uint32 0, and uint64 offset
+    * columns of kind INT64, an int64 per unit: bytes, characters, loc, classes,
+      functions, declarations, expressions, and comments
+    * columns of kind STRING, a uint64 offset into the string table and uint64
+      length per unit: filename and url
+    * string table of the bytes of the strings
+*/
+class UnitColumnsWriter {
+public:
+    enum Kind : uint32_t { INT64 = 0, STRING = 1 };
+
+    /*
+        Create the file, with space for the columns of all units
+
+        @param[in] path Path of the file
+        @param[in] unitCount Number of units
+    */
+    UnitColumnsWriter(const char* path, std::size_t unitCount);
+    ~UnitColumnsWriter();
+    UnitColumnsWriter(const UnitColumnsWriter&) = delete;
+    UnitColumnsWriter& operator=(const UnitColumnsWriter&) = delete;
+
+    // whether the file was created
+    bool isOpen() const {
+        return fd != -1;
+    }
+
+    /*
+        Add the measures of the next unit
+
+        @param[in] facts Measures of the unit
+        @param[in] filename Filename of the unit
+        @return Whether the writes succeeded
+    */
+    bool add(const Facts& facts, std::string_view filename);
+
+    /*
+        Write the rest of the columns and the header
+
+        @return Whether all of the file was written
+    */
+    bool finish();
+
+private:
+    bool writeBlock();
+    bool writeStrings();
+
+    int fd = -1;
+    std::size_t unitCount = 0;
+
+    // offset of each column
+    std::vector<uint64_t> offsets;
+
+    // block of values of each column, from the first unit of the block
+    std::vector<std::vector<int64_t>> values;
+    std::size_t blockStart = 0;
+    std::size_t added = 0;
+
+    // string table, with the offset of its buffered bytes
+    uint64_t stringsOffset = 0;
+    uint64_t stringsSize = 0;
+    std::string strings;
+};
+
+#endif
@@ -0,0 +1,189 @@
+/*
+    unitFilter.cpp
+
+    Subset of the units of a srcML archive, passed through unchanged.
+*/
+
+#include "unitFilter.hpp"
+#include "writeSlices.hpp"
+#include <algorithm>
+#include <functional>
+#include <fnmatch.h>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+/*
+    @param[in] filenamePattern Glob of the filenames of the units to keep, empty for any
+    @param[in] language Language of the units to keep, empty for any
+*/
+UnitFilter::UnitFilter(std::string filenamePattern, std::string language)
+    : filenamePattern(std::move(filenamePattern)), language(std::move(language)) {
+    analyzer.recordEvents(&parseEvents);
+}
+
+/*
+    Write the srcML of the matching units
+
+    @param[in] input Source of srcML
+    @param[in] fd File descriptor for the srcML
+    @return Whether all output was written
+*/
+bool UnitFilter::run(InputSource& input, int fd) {
+    bool isDone = false;
+    while (!isDone) {
+        if (analyzer.read(input) == 0) {
+            analyzer.finish();
+            isDone = true;
+        }
+
+        // the ranges to pass continue from the start of the parsed data
+        const std::string_view parsed = analyzer.parsed();
+        passStart = parsed.data();
+        markupEnd = nullptr;
+        for (const ParseEvent& event : parseEvents) {
+            if (!update(event, parsed, fd))
+                return false;
+        }
+
+        // output the data before the refill, except for a unit start tag still being decided
+        const char* parsedEnd = parsed.data() + parsed.size();
+        if (state == PASS)
+            write(passStart, parsedEnd);
+        else if (state == DECIDING)
+            deciding.append(passStart, parsedEnd);
+        if (!writeSlices(fd, slices))
+            return false;
+    }
+    return true;
+}
+
+/*
+    Update the unit ranges with the next parse event
+
+    @param[in] event Parse event
+    @param[in] parsed Data parsed by the last read
+    @param[in] fd File descriptor for the srcML
+    @return Whether all output was written
+*/
+bool UnitFilter::update(const ParseEvent& event, std::string_view parsed, int fd) {
+    // the unit start tag ends at the first event that is not an attribute or namespace
+    if (state == DECIDING && event.type != ParseEvent::ATTRIBUTE && event.type != ParseEvent::NAMESPACE) {
+        if (!decide(fd))
+            return false;
+    }
+    const bool wasAfterSkip = isAfterSkip;
+    isAfterSkip = false;
+
+    // end of the last tag name, or closing quote of a value, in the parsed data of a unit being skipped
+    const char* parsedEnd = parsed.data() + parsed.size();
+    const auto isInData = [&parsed, parsedEnd](std::string_view view) {
+        return std::less_equal<const char*>()(parsed.data(), view.data())
+            && std::less_equal<const char*>()(view.data() + view.size(), parsedEnd);
+    };
+    if (state != PASS && (event.type == ParseEvent::START_TAG || event.type == ParseEvent::END_TAG)) {
+        // the end tag of an empty element has the name of its start tag, before any attributes
+        const char* nameEnd = event.name.data() + event.name.size();
+        if (isInData(event.name) && std::less<const char*>()(markupEnd, nameEnd))
+            markupEnd = nameEnd;
+    } else if (state != PASS && (event.type == ParseEvent::ATTRIBUTE || event.type == ParseEvent::NAMESPACE)) {
+        if (isInData(event.value))
+            markupEnd = event.value.data() + event.value.size() + 1;
+    }
+    switch (event.type) {
+    case ParseEvent::START_TAG:
+        ++depth;
+        if (state == PASS && depth <= 2 && event.prefix.empty() && event.name == "unit"sv) {
+            // unit of an archive, or a single unit
+            const char* tagStart = event.name.data() - 1;
+            write(passStart, tagStart);
+            passStart = tagStart;
+            state = DECIDING;
+            unitDepth = depth;
+            hasUnitAttributes = false;
+            unitFilename.clear();
+            unitLanguage.clear();
+            deciding.clear();
+        }
+        break;
+    case ParseEvent::ATTRIBUTE:
+        if (state == DECIDING && event.prefix.empty()) {
+            if (event.name == "filename"sv) {
+                unitFilename = event.value;
+                hasUnitAttributes = true;
+            } else if (event.name == "language"sv) {
+                unitLanguage = event.value;
+                hasUnitAttributes = true;
+            }
+        }
+        break;
+    case ParseEvent::END_TAG:
+        if (state == SKIP && depth == unitDepth) {
+            // the tag ends at the first '>' after its name and values, since a value can
+            // have a '>', or at the start of this data for a start tag split across reads
+            passStart = std::find(markupEnd ? markupEnd : parsed.data(), parsedEnd, '>') + 1;
+            state = PASS;
+            isAfterSkip = true;
+            --depth;
+            return true;
+        }
+        --depth;
+        break;
+    case ParseEvent::CHARACTERS:
+        // whitespace between units goes with the skipped unit
+        if (wasAfterSkip && event.value.data() == passStart)
+            passStart += event.value.size();
+        break;
+    default:
+        break;
+    }
+    return true;
+}
+
+/*
+    Decide whether to keep the unit from its start tag
+
+    @param[in] fd File descriptor for the srcML
+    @return Whether all output was written
+*/
+bool UnitFilter::decide(int fd) {
+    if (!isMatch()) {
+        state = SKIP;
+        return true;
+    }
+    state = PASS;
+    if (deciding.empty())
+        return true;
+
+    // start of the start tag from before the last refill
+    write(deciding.data(), deciding.data() + deciding.size());
+    return writeSlices(fd, slices);
+}
+
+/*
+    Whether the current unit is kept
+
+    @return Whether the unit matches the filename pattern and language
+*/
+bool UnitFilter::isMatch() const {
+    // root unit of an archive
+    if (unitDepth == 1 && !hasUnitAttributes)
+        return true;
+    if (!filenamePattern.empty() && fnmatch(filenamePattern.c_str(), unitFilename.c_str(), 0) != 0)
+        return false;
+    if (!language.empty() && unitLanguage != language)
+        return false;
+    return true;
+}
+
+/*
+    Add a range of the input to the output
+
+    @param[in] first Start of the range
+    @param[in] last End of the range
+*/
+void UnitFilter::write(const char* first, const char* last) {
+    if (first == last)
+        return;
+    slices.push_back({ const_cast<char*>(first), static_cast<size_t>(last - first) });
+}
@@ -0,0 +1,70 @@
+/*
+    unitFilter.hpp
+
+    Subset of the units of a srcML archive, passed through unchanged.
+*/
+
+#ifndef INCLUDED_UNITFILTER_HPP
+#define INCLUDED_UNITFILTER_HPP
+
+#include "analyze.hpp"
+#include "parseEvent.hpp"
+#include <string>
+#include <vector>
+#include <sys/uio.h>
+
+/*
+    Filter of the units of srcML by filename and language. The output is the
+    input without the units that do not match, copied as byte ranges of the
+    input buffer with writev(), so the srcML is never reserialized.
+    The root unit of an archive, without a filename or language, is kept.
+*/
+class UnitFilter {
+public:
+    /*
+        @param[in] filenamePattern Glob of the filenames of the units to keep, empty for any
+        @param[in] language Language of the units to keep, empty for any
+    */
+    UnitFilter(std::string filenamePattern, std::string language);
+
+    /*
+        Write the srcML of the matching units
+
+        @param[in] input Source of srcML
+        @param[in] fd File descriptor for the srcML
+        @return Whether all output was written
+    */
+    bool run(InputSource& input, int fd);
+
+    // facts of the input
+    const Facts& facts() const {
+        return analyzer.facts();
+    }
+
+private:
+    bool isMatch() const;
+    bool update(const ParseEvent& event, std::string_view parsed, int fd);
+    bool decide(int fd);
+    void write(const char* first, const char* last);
+
+    std::string filenamePattern;
+    std::string language;
+    Analyzer analyzer;
+    std::vector<ParseEvent> parseEvents;
+    std::vector<iovec> slices;
+
+    // state of the unit ranges
+    enum State { PASS, DECIDING, SKIP };
+    State state = PASS;
+    const char* passStart = nullptr;
+    const char* markupEnd = nullptr;
+    int depth = 0;
+    int unitDepth = 0;
+    bool hasUnitAttributes = false;
+    bool isAfterSkip = false;
+    std::string unitFilename;
+    std::string unitLanguage;
+    std::string deciding;
+};
+
+#endif
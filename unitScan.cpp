@@ -0,0 +1,160 @@
+/*
+    unitScan.cpp
+
+    Whole srcML input in memory, a quick scan of it for the units of an
+    archive, without parsing, and the analyses of the units in flight.
+*/
+
+#include "unitScan.hpp"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <cctype>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// provides literal string operator""sv
+using namespace std::literals::string_view_literals;
+
+/*
+    @param[in] fd File descriptor of the input, mapped if it is a regular file
+*/
+InputData::InputData(int fd) {
+    struct stat status{};
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        void* mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            data = std::string_view(static_cast<const char*>(mapped), status.st_size);
+            return;
+        }
+    }
+    char buffer[64 * 1024];
+    ssize_t readBytes = 0;
+    while ((readBytes = read(fd, buffer, sizeof(buffer))) > 0 || (readBytes == -1 && errno == EINTR)) {
+        if (readBytes > 0)
+            copy.append(buffer, readBytes);
+    }
+    isError = readBytes == -1;
+    data = copy;
+}
+
+InputData::~InputData() {
+    if (copy.empty() && !data.empty())
+        munmap(const_cast<char*>(data.data()), data.size());
+}
+
+/*
+    Split an archive into its units by a scan for the unit start tags
+
+    @param[in] srcML srcML archive
+    @return srcML of each unit, or of the whole document if it is not an archive
+*/
+std::vector<std::string_view> findUnits(std::string_view srcML) {
+    constexpr std::string_view UNIT_START = "<unit"sv;
+    constexpr std::string_view UNIT_END = "</unit>"sv;
+    const std::boyer_moore_horspool_searcher searcher(UNIT_START.begin(), UNIT_START.end());
+    std::vector<std::size_t> starts;
+    for (auto position = srcML.begin(); ; ) {
+        position = std::search(position, srcML.end(), searcher);
+        if (position == srcML.end())
+            break;
+        const auto next = position + UNIT_START.size();
+        if (next != srcML.end() && (*next == ' ' || *next == '>' || *next == '\n' || *next == '\t' || *next == '\r'))
+            starts.push_back(position - srcML.begin());
+        position = next;
+    }
+    if (starts.size() < 2)
+        return { srcML };
+
+    // units of the archive end at the next unit, or at the end tag of the root unit,
+    // without the whitespace between them, so the same unit is the same anywhere
+    std::vector<std::string_view> units;
+    std::size_t rootEnd = srcML.rfind(UNIT_END);
+    // a truncated archive, without the end tag of the root unit, ends at the end of the input
+    if (rootEnd == std::string_view::npos || rootEnd < starts.back())
+        rootEnd = srcML.size();
+    for (std::size_t i = 1; i < starts.size(); ++i) {
+        std::size_t end = i + 1 < starts.size() ? starts[i + 1] : rootEnd;
+        while (end > starts[i] && isspace(static_cast<unsigned char>(srcML[end - 1])))
+            --end;
+        units.push_back(srcML.substr(starts[i], end - starts[i]));
+    }
+    return units;
+}
+
+/*
+    End of the start tag of a unit, after any '>' in its attribute values
+
+    @param[in] unit srcML of the unit
+    @return Position after the start tag, or the size of the unit if it is incomplete
+*/
+std::size_t startTagEnd(std::string_view unit) {
+    char quote = 0;
+    for (std::size_t i = 0; i < unit.size(); ++i) {
+        const char c = unit[i];
+        if (quote) {
+            if (c == quote)
+                quote = 0;
+        } else if (c == '"' || c == '\'') {
+            quote = c;
+        } else if (c == '>') {
+            return i + 1;
+        }
+    }
+    return unit.size();
+}
+
+/*
+    srcML of an archive outside of its units, i.e., the root unit with the
+    text between the units, for the measures of that text
+
+    @param[in] srcML srcML archive
+    @param[in] units Units of the archive from findUnits()
+    @return srcML outside the units, empty if it is not an archive
+*/
+std::string outsideUnits(std::string_view srcML, const std::vector<std::string_view>& units) {
+    if (units.size() == 1 && units.front().size() == srcML.size())
+        return "";
+    std::string outside;
+    std::size_t position = 0;
+    for (const std::string_view unit : units) {
+        const std::size_t start = unit.data() - srcML.data();
+        outside.append(srcML.substr(position, start - position));
+        position = start + unit.size();
+    }
+    outside.append(srcML.substr(position));
+    return outside;
+}
+
+UnitAnalyses::UnitAnalyses() {
+    options.cancelled = std::make_shared<std::atomic<bool>>(false);
+}
+
+UnitAnalyses::~UnitAnalyses() {
+    // queued analyses stop before reading their unit, and running ones at their next refill
+    options.cancelled->store(true);
+    for (const std::future<Facts>& result : inFlight)
+        result.wait();
+}
+
+/*
+    Start the analysis of a unit
+
+    @param[in] unit srcML of the unit, in the input
+*/
+void UnitAnalyses::submit(std::string_view unit) {
+    inFlight.push_back(analyzeAsync(std::make_unique<StringSource>(unit), options));
+}
+
+/*
+    Wait for the measures of the first unit not yet used
+
+    @return Measures of the unit, with a ParseError exception on failure
+*/
+Facts UnitAnalyses::next() {
+    std::future<Facts> result = std::move(inFlight.front());
+    inFlight.pop_front();
+    return result.get();
+}
@@ -0,0 +1,104 @@
+/*
+    unitScan.hpp
+
+    Whole srcML input in memory, a quick scan of it for the units of an
+    archive, without parsing, and the analyses of the units in flight.
+*/
+
+#ifndef INCLUDED_UNITSCAN_HPP
+#define INCLUDED_UNITSCAN_HPP
+
+#include "analyzeAsync.hpp"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+
+/*
+    Input from a mapped file, or from memory read from a pipe
+*/
+class InputData {
+public:
+    /*
+        @param[in] fd File descriptor of the input, mapped if it is a regular file
+    */
+    explicit InputData(int fd);
+    ~InputData();
+    InputData(const InputData&) = delete;
+    InputData& operator=(const InputData&) = delete;
+
+    // input data
+    std::string_view data;
+
+    // whether reading the input failed
+    bool isError = false;
+
+private:
+    std::string copy;
+};
+
+/*
+    Split an archive into its units by a scan for the unit start tags
+
+    @param[in] srcML srcML archive
+    @return srcML of each unit, or of the whole document if it is not an archive
+*/
+std::vector<std::string_view> findUnits(std::string_view srcML);
+
+/*
+    End of the start tag of a unit, after any '>' in its attribute values
+
+    @param[in] unit srcML of the unit
+    @return Position after the start tag, or the size of the unit if it is incomplete
+*/
+std::size_t startTagEnd(std::string_view unit);
+
+/*
+    srcML of an archive outside of its units, i.e., the root unit with the
+    text between the units, for the measures of that text
+
+    @param[in] srcML srcML archive
+    @param[in] units Units of the archive from findUnits()
+    @return srcML outside the units, empty if it is not an archive
+*/
+std::string outsideUnits(std::string_view srcML, const std::vector<std::string_view>& units);
+
+/*
+    Analyses of units on the analyzeAsync() thread pool, with their results
+    in order of submission. The units are views of the InputData, so when
+    the analyses are destroyed, e.g., on an error, any still in flight are
+    cancelled and waited for. Declare them after the InputData, so they end
+    before the input is released.
+*/
+class UnitAnalyses {
+public:
+    UnitAnalyses();
+    ~UnitAnalyses();
+    UnitAnalyses(const UnitAnalyses&) = delete;
+    UnitAnalyses& operator=(const UnitAnalyses&) = delete;
+
+    /*
+        Start the analysis of a unit
+
+        @param[in] unit srcML of the unit, in the input
+    */
+    void submit(std::string_view unit);
+
+    /*
+        Wait for the measures of the first unit not yet used
+
+        @return Measures of the unit, with a ParseError exception on failure
+    */
+    Facts next();
+
+    // number of analyses submitted and not yet used
+    std::size_t size() const {
+        return inFlight.size();
+    }
+
+private:
+    AsyncOptions options;
+    std::deque<std::future<Facts>> inFlight;
+};
+
+#endif
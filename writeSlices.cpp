@@ -0,0 +1,50 @@
+/*
+    writeSlices.cpp
+
+    Gathered output of slices of memory with writev().
+*/
+
+#include "writeSlices.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*
+    Write all of the slices, resuming partial and interrupted writes. The
+    slices are cleared, and their contents may be changed.
+
+    @param[in] fd File descriptor
+    @param[in,out] slices Slices to write
+    @return Whether all slices were written
+*/
+bool writeSlices(int fd, std::vector<iovec>& slices) {
+    iovec* slice = slices.data();
+    int count = static_cast<int>(slices.size());
+    while (count > 0) {
+        // writev() takes at most IOV_MAX slices at a time
+        ssize_t written = writev(fd, slice, std::min(count, IOV_MAX));
+        if (written == -1 && errno == EINTR)
+            continue;
+        if (written <= 0) {
+            slices.clear();
+            return false;
+        }
+        // skip the written slices, and the written part of a partial slice
+        while (count > 0 && static_cast<size_t>(written) >= slice->iov_len) {
+            written -= slice->iov_len;
+            ++slice;
+            --count;
+        }
+        if (count > 0) {
+            slice->iov_base = static_cast<char*>(slice->iov_base) + written;
+            slice->iov_len -= written;
+        }
+    }
+    slices.clear();
+    return true;
+}
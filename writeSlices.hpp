@@ -0,0 +1,23 @@
+/*
+    writeSlices.hpp
+
+    Gathered output of slices of memory with writev().
+*/
+
+#ifndef INCLUDED_WRITESLICES_HPP
+#define INCLUDED_WRITESLICES_HPP
+
+#include <vector>
+#include <sys/uio.h>
+
+/*
+    Write all of the slices, resuming partial and interrupted writes. The
+    slices are cleared, and their contents may be changed.
+
+    @param[in] fd File descriptor
+    @param[in,out] slices Slices to write
+    @return Whether all slices were written
+*/
+bool writeSlices(int fd, std::vector<iovec>& slices);
+
+#endif